@@ -0,0 +1,158 @@
+#pragma once
+
+#include "rideExecutor.h"
+#include "geoPoint.h"
+#include "fleetTable.h"
+#include "geoLocation.h"
+#include "riskScoring.h"
+#include "allocationWorkers.h"
+
+// --------------------- Admission control (rate limits & load shedding) -------------------------
+
+// Token buckets for many keys in locked open-addressing shards. Buckets refill lazily on
+// access; a full bucket is the same as a missing one and is dropped when the shard needs room.
+class TokenBucketTable {
+private:
+    struct Entry {
+        uint64_t key;
+        int64_t lastMs;
+        float tokens;
+        bool occupied;
+    };
+
+    struct Shard {
+        mutex mtx;
+        vector<Entry> slots;
+        size_t used = 0;
+    };
+
+    static constexpr size_t shardCount = 16;
+    static constexpr size_t initialSlots = 64;
+
+    Shard shards[shardCount];
+    double ratePerMs;
+    float burst;
+
+    // Keys are often sequential, so they are mixed before picking the shard and slot.
+    static uint64_t spread(uint64_t key) {
+        return mix64(key);
+    }
+
+    float refilled(const Entry& e, int64_t nowMs) const {
+        return (float)min<double>(burst, e.tokens + (double)max<int64_t>(nowMs - e.lastMs, 0) * ratePerMs);
+    }
+
+    // Caller holds the shard lock. Drops full buckets, growing the shard if still over half used.
+    void compact(Shard& s, int64_t nowMs) {
+        vector<Entry> live;
+        for (const Entry& e : s.slots) {
+            if (e.occupied && refilled(e, nowMs) < burst) live.push_back(e);
+        }
+        size_t capacity = initialSlots;
+        while (capacity < live.size() * 2) capacity *= 2;
+        s.slots.assign(capacity, Entry{0, 0, 0, false});
+        s.used = live.size();
+        for (const Entry& e : live) {
+            size_t i = (spread(e.key) >> 4) & (capacity - 1);
+            while (s.slots[i].occupied) i = (i + 1) & (capacity - 1);
+            s.slots[i] = e;
+        }
+    }
+
+public:
+    TokenBucketTable(float burst, double perSecond) {
+        this->burst = burst;
+        this->ratePerMs = perSecond / 1000.0;
+        for (Shard& s : shards) s.slots.assign(initialSlots, Entry{0, 0, 0, false});
+    }
+
+    // Takes one token from the key's bucket; false if it is empty.
+    bool tryTake(uint64_t key, int64_t nowMs) {
+        uint64_t h = spread(key);
+        Shard& s = shards[h % shardCount];
+        lock_guard<mutex> lock(s.mtx);
+        if ((s.used + 1) * 4 > s.slots.size() * 3) compact(s, nowMs);
+        size_t mask = s.slots.size() - 1;
+        size_t i = (h >> 4) & mask;
+        while (s.slots[i].occupied && s.slots[i].key != key) i = (i + 1) & mask;
+        Entry& e = s.slots[i];
+        if (!e.occupied) {
+            e = Entry{key, nowMs, burst, true};
+            s.used++;
+        }
+        e.tokens = refilled(e, nowMs);
+        e.lastMs = nowMs;
+        if (e.tokens < 1) return false;
+        e.tokens -= 1;
+        return true;
+    }
+
+    bool tryTake(const string& key, int64_t nowMs) {
+        return tryTake((uint64_t)hash<string>{}(key), nowMs);
+    }
+};
+
+// Decides at intake whether a request may go further: load shedding while the allocation
+// workers are behind, then per-user and per-pickup-cell token buckets.
+class AdmissionController {
+public:
+    enum Decision { Admitted, Overloaded, UserLimited, CellLimited };
+
+private:
+    iClock* clock;
+    GeoLocationManager* gm;
+    AllocationWorkerPool* workers; // null: no load shedding
+    TokenBucketTable userBookings;
+    TokenBucketTable cellBookings;
+    TokenBucketTable logins;
+
+public:
+    size_t maxQueueDepth = 512;
+    uint64_t maxQueueWaitMicros = 50000;
+    atomic<uint64_t> shedCount{0};
+    atomic<uint64_t> limitedCount{0};
+
+    AdmissionController(iClock* clock, GeoLocationManager* gm, AllocationWorkerPool* workers)
+        : clock(clock), gm(gm), workers(workers),
+          userBookings(3, 0.1),  // a burst of 3, then one booking per 10 s
+          cellBookings(50, 20),  // a busy cell: 20 bookings/s sustained
+          logins(5, 1) {}
+
+    static const char* describe(Decision d) {
+        switch (d) {
+            case Admitted: return "admitted";
+            case Overloaded: return "service overloaded";
+            case UserLimited: return "too many bookings from this user";
+            default: return "too many bookings from this area";
+        }
+    }
+
+    bool overloaded() {
+        return workers && (workers->pending() > maxQueueDepth || workers->oldestWaitMicros() > maxQueueWaitMicros);
+    }
+
+    Decision admitBooking(const string& userName, const string& pickup) {
+        if (overloaded()) {
+            shedCount.fetch_add(1, memory_order_relaxed);
+            return Overloaded;
+        }
+        int64_t now = clock->nowMs();
+        if (!userBookings.tryTake(userName, now)) {
+            limitedCount.fetch_add(1, memory_order_relaxed);
+            return UserLimited;
+        }
+        GeoPoint p;
+        uint64_t cell = gm->resolve(pickup, p) ? FleetTable::cellOf(p) : hash<string>{}(pickup);
+        if (!cellBookings.tryTake(cell, now)) {
+            limitedCount.fetch_add(1, memory_order_relaxed);
+            return CellLimited;
+        }
+        return Admitted;
+    }
+
+    bool admitLogin(const string& userName) {
+        if (logins.tryTake(userName, clock->nowMs())) return true;
+        limitedCount.fetch_add(1, memory_order_relaxed);
+        return false;
+    }
+};
@@ -0,0 +1,72 @@
+#pragma once
+
+#include "rideLogger.h"
+#include "rideObject.h"
+#include "rideConfig.h"
+#include "bookingSubject.h"
+#include "driverAllocation.h"
+#include "notifications.h"
+
+// This class will now be responsible for allocating the driver and notifying the ride request manager
+// that a driver has been allocated. It itself observes the booking subject.
+class DriverAllocationManager : public iBookingObserver {
+    rideAllocationFactory* f;
+    NotificationEngine* notificationEngine; 
+public:
+    DriverAllocationManager(rideAllocationFactory* f, NotificationEngine* ne) {
+        this->f = f;
+        this->notificationEngine = ne;
+    }
+
+    void notifyBookingDetails(RideObject* r) override {
+        LOG_INFO("[DriverAllocationManager] Notified of new booking for {}. Attempting to allocate driver...", r->name);
+        f->allocateDriver(r);
+        if (r->rideStatus == "confirmed") {
+            LOG_INFO("[DriverAllocationManager] Driver {} allocated for ride.", r->driverName);
+            // Notify the driver that a new booking is available for them
+            notificationEngine->notifyDriver("New ride request from " + r->name + " to " + r->dest + ". Please accept.", r->driverName);
+        } else {
+            LOG_WARN("[DriverAllocationManager] Failed to allocate driver for ride.");
+        }
+    }
+    ~DriverAllocationManager() {
+        delete f;
+    }
+};
+
+
+class IDriverAllocationOrchestrator {
+public:
+    virtual void orchestrate(RideObject* r) = 0;
+    virtual ~IDriverAllocationOrchestrator() {}
+};
+
+// Concrete Implementation for Driver Allocation Orchestration
+// This will now be part of the RideRequestManager's logic
+class ConcreteDriverAllocationOrchestrator : public IDriverAllocationOrchestrator {
+    NotificationEngine* notificationEngine;
+    IDriverAllocationStrategySelector* strategySelector;
+    string strategyName;
+    ConfigStore* config; // when set, the configured strategy wins over strategyName
+public:
+    ConcreteDriverAllocationOrchestrator(NotificationEngine* ne, IDriverAllocationStrategySelector* dss, string strategyName = "nearestDriver")
+        : notificationEngine(ne), strategySelector(dss), strategyName(strategyName), config(nullptr) {}
+
+    ConcreteDriverAllocationOrchestrator(NotificationEngine* ne, IDriverAllocationStrategySelector* dss, ConfigStore* config)
+        : notificationEngine(ne), strategySelector(dss), config(config) {}
+
+    void orchestrate(RideObject* r) override {
+        // This is simplified as the actual allocation happens through the observer now
+        // For a true orchestration, it would directly interact with driver management
+        // and a driver allocation service.
+        // it will call DriverAllocationManager directly to simulate
+        // the immediate allocation once booking details are received.
+        string name = config ? config->snapshot()->allocationStrategy : strategyName;
+        iDriverAllocationStratergy* strategy = strategySelector->selectStrategy(name); // nearestDriver or highestRating
+        rideAllocationFactory* factory = new rideAllocationFactory(strategy);
+        DriverAllocationManager* allocator = new DriverAllocationManager(factory, notificationEngine); // Pass notification engine
+
+        allocator->notifyBookingDetails(r); // Simulate direct call to allocation
+        delete allocator;
+    }
+};
@@ -0,0 +1,131 @@
+#pragma once
+
+#include "rideCommon.h"
+
+// --------------------- Allocation workers (work-stealing pool) -------------------------
+
+// Runs driver allocations off the booking thread. Jobs go to the worker their pickup cell maps
+// to; idle workers steal the oldest job of another, which spreads a burst from one area.
+class AllocationWorkerPool {
+private:
+    struct QueuedJob {
+        function<void()> run;
+        chrono::steady_clock::time_point queuedAt;
+    };
+
+    struct WorkerQueue {
+        mutex mtx;
+        deque<QueuedJob> jobs; // oldest at the front
+    };
+
+    vector<WorkerQueue*> queues;
+    vector<thread> workers;
+    mutex mtx;
+    condition_variable workCv;
+    condition_variable idleCv;
+    atomic<size_t> queued{0};
+    size_t unfinished = 0; // guarded by mtx: submitted but not yet completed
+    bool stopping = false;
+
+    bool popOwn(size_t self, function<void()>& job) {
+        WorkerQueue* q = queues[self];
+        lock_guard<mutex> lock(q->mtx);
+        if (q->jobs.empty()) return false;
+        job = move(q->jobs.back().run);
+        q->jobs.pop_back();
+        return true;
+    }
+
+    bool steal(size_t self, function<void()>& job) {
+        for (size_t i = 1; i < queues.size(); i++) {
+            WorkerQueue* q = queues[(self + i) % queues.size()];
+            lock_guard<mutex> lock(q->mtx);
+            if (q->jobs.empty()) continue;
+            job = move(q->jobs.front().run);
+            q->jobs.pop_front();
+            steals.fetch_add(1, memory_order_relaxed);
+            return true;
+        }
+        return false;
+    }
+
+    void workerLoop(size_t self) {
+        while (true) {
+            function<void()> job;
+            if (popOwn(self, job) || steal(self, job)) {
+                queued.fetch_sub(1);
+                job();
+                lock_guard<mutex> lock(mtx);
+                if (--unfinished == 0) idleCv.notify_all();
+                continue;
+            }
+            unique_lock<mutex> lock(mtx);
+            workCv.wait(lock, [this] { return stopping || queued.load() > 0; });
+            if (stopping && queued.load() == 0) return;
+        }
+    }
+
+public:
+    atomic<uint64_t> steals{0};
+
+    AllocationWorkerPool(int threadCount) {
+        for (int i = 0; i < threadCount; i++) {
+            queues.push_back(new WorkerQueue());
+        }
+        for (int i = 0; i < threadCount; i++) {
+            workers.emplace_back(&AllocationWorkerPool::workerLoop, this, (size_t)i);
+        }
+    }
+
+    size_t size() {
+        return workers.size();
+    }
+
+    // Jobs waiting for a worker.
+    size_t pending() {
+        return queued.load();
+    }
+
+    // How long the oldest job still waiting for a worker has waited; 0 when none waits.
+    uint64_t oldestWaitMicros() {
+        auto now = chrono::steady_clock::now();
+        auto oldest = now;
+        for (WorkerQueue* q : queues) {
+            lock_guard<mutex> lock(q->mtx);
+            if (!q->jobs.empty()) oldest = min(oldest, q->jobs.front().queuedAt);
+        }
+        return (uint64_t)chrono::duration_cast<chrono::microseconds>(now - oldest).count();
+    }
+
+    void submit(uint64_t localityKey, function<void()> job) {
+        WorkerQueue* q = queues[localityKey % queues.size()];
+        {
+            // Counted under mtx so a worker about to sleep cannot miss it
+            lock_guard<mutex> lock(mtx);
+            unfinished++;
+            queued.fetch_add(1);
+        }
+        {
+            lock_guard<mutex> lock(q->mtx);
+            q->jobs.push_back(QueuedJob{move(job), chrono::steady_clock::now()});
+        }
+        workCv.notify_one();
+    }
+
+    // Blocks until every submitted job has run.
+    void drain() {
+        unique_lock<mutex> lock(mtx);
+        idleCv.wait(lock, [this] { return unfinished == 0; });
+    }
+
+    ~AllocationWorkerPool() {
+        drain();
+        {
+            lock_guard<mutex> lock(mtx);
+            stopping = true;
+        }
+        workCv.notify_all();
+        for (auto& w : workers) w.join();
+        for (WorkerQueue* q : queues) delete q;
+    }
+};
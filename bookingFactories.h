@@ -0,0 +1,146 @@
+#pragma once
+
+#include "rideObject.h"
+
+// --------------------- IBooking Interface -------------------------
+class iBooking {
+public:
+    RideObject* r;
+    iBooking(RideObject* r) {
+        this->r = r;
+    }
+
+    virtual void book(RideObject* r) = 0;
+    virtual ~iBooking() {}
+};
+
+// --------------------- Concrete Booking Class -------------------------
+class bookRide : public iBooking {
+public:
+    bookRide(RideObject* r) : iBooking(r) {}
+
+    void book(RideObject* r) override {
+        cout << "Enter your name: ";
+        cin >> r->name;
+
+        cout << "Enter pickup location: ";
+        cin >> r->start;
+
+        cout << "Enter destination: ";
+        cin >> r->dest;
+
+        cout << "Enter ride type (normal/pooling): ";
+        cin >> r->rideType;
+
+        cout << "Enter vehicle (sedan/suv/auto): ";
+        cin >> r->vehicle;
+    }
+};
+
+// --------------------- Ride Type Factory Interface -------------------------
+class vehicleTypeFactory {
+public:
+    virtual void createBooking(RideObject* r) = 0;
+    virtual ~vehicleTypeFactory() {}
+};
+
+// --------------------- Concrete Ride Type Factories -------------------------
+class normalRideFactory : public vehicleTypeFactory {
+public:
+    void createBooking(RideObject* r) override {
+        r->rideType = "normal";
+        cout << "Normal booking created for you.\n";
+    }
+};
+
+class poolingRideFactory : public vehicleTypeFactory {
+public:
+    void createBooking(RideObject* r) override {
+        r->rideType = "pooling";
+        cout << "Pooling booking created for you.\n";
+    }
+};
+
+// New Interface for selecting RideTypeFactory
+class IRideTypeFactorySelector {
+public:
+    virtual vehicleTypeFactory* selectRideTypeFactory(const string& rideType) = 0;
+    virtual ~IRideTypeFactorySelector() {}
+};
+
+// Concrete implementation for selecting RideTypeFactory
+class RideTypeFactorySelector : public IRideTypeFactorySelector {
+public:
+    vehicleTypeFactory* selectRideTypeFactory(const string& rideType) override {
+        if (rideType == "normal") {
+            return new normalRideFactory();
+        } else {
+            return new poolingRideFactory();
+        }
+    }
+};
+
+
+// --------------------- Vehicle Factory Interface -------------------------
+class iVehicleTypeFactory {
+public:
+    virtual void bookVehicle(RideObject* r) = 0;
+    virtual ~iVehicleTypeFactory() {}
+};
+
+// --------------------- Concrete Vehicle Factories -------------------------
+class Car : public iVehicleTypeFactory {
+public:
+    void bookVehicle(RideObject* r) override {
+        r->vehicle = "car";
+        cout << "Car vehicle booked.\n";
+    }
+};
+
+class Sedan : public Car {
+public:
+    void bookVehicle(RideObject* r) override {
+        r->vehicle = "car";
+        r->vehicleType = "sedan";
+        cout << "Sedan booked.\n";
+    }
+};
+
+class SUV : public Car {
+public:
+    void bookVehicle(RideObject* r) override {
+        r->vehicle = "car";
+        r->vehicleType = "suv";
+        cout << "SUV booked.\n";
+    }
+};
+
+class Auto : public iVehicleTypeFactory {
+public:
+    void bookVehicle(RideObject* r) override {
+        r->vehicle = "auto";
+        r->vehicleType = "3-wheeler";
+        cout << "Auto vehicle booked.\n";
+    }
+};
+
+//Interface for selecting VehicleTypeFactory
+class IVehicleFactorySelector {
+public:
+    virtual iVehicleTypeFactory* selectVehicleFactory(const string& vehicle) = 0;
+    virtual ~IVehicleFactorySelector() {}
+};
+
+// Concrete implementation for selecting VehicleTypeFactory
+class VehicleFactorySelector : public IVehicleFactorySelector {
+public:
+    iVehicleTypeFactory* selectVehicleFactory(const string& vehicle) override {
+        if (vehicle == "sedan") {
+            return new Sedan();
+        } else if (vehicle == "suv") {
+            return new SUV();
+        } else {
+            return new Auto();
+        }
+    }
+};
@@ -0,0 +1,47 @@
+#pragma once
+
+#include "rideObject.h"
+
+//notify the ride allocation factory that a new ride object is created and they use suitable stratergy to allocate driver
+// Observers may only use the ride during the call; the allocation observer goes last.
+class iBookingObserver {
+public:
+    virtual void notifyBookingDetails(RideObject* r) = 0;
+    // A ride restored from a snapshot, already counted before the restart.
+    virtual void notifyRestoredRide(RideObject*) {}
+    virtual ~iBookingObserver() {}
+};
+
+class iBookingSubject {
+protected:
+    vector<iBookingObserver*> observers;
+public:
+    virtual void addObservers(iBookingObserver* obs) = 0;
+    virtual void removeObservers(iBookingObserver* obs) = 0;
+    virtual void notify(RideObject* r) = 0;
+    virtual void notifyRestored(RideObject* r) = 0;
+    virtual ~iBookingSubject() {} // observers belong to whoever created them
+};
+
+class BookingSubject : public iBookingSubject {
+public:
+    void addObservers(iBookingObserver* obs) override {
+        observers.push_back(obs);
+    }
+
+    void removeObservers(iBookingObserver* obs) override {
+        observers.erase(remove(observers.begin(), observers.end(), obs), observers.end());
+    }
+
+    void notify(RideObject* r) override {
+        for (auto obs : observers) {
+            obs->notifyBookingDetails(r);
+        }
+    }
+
+    void notifyRestored(RideObject* r) override {
+        for (auto obs : observers) {
+            obs->notifyRestoredRide(r);
+        }
+    }
+};
@@ -0,0 +1,190 @@
+#pragma once
+
+#include "rideExecutor.h"
+#include "geoPoint.h"
+#include "fleetTable.h"
+#include "geoLocation.h"
+#include "rideObject.h"
+#include "bookingSubject.h"
+#include "driverAllocation.h"
+#include "notifications.h"
+
+// ------------------------ Demand forecasting & driver repositioning ------------------------
+
+// Per-cell booking counts with a Holt (level + trend) forecast, rolled forward each minute;
+// idle drivers in over-supplied cells are nudged towards cells expected to run short.
+class DemandForecaster : public iBookingObserver {
+private:
+    static constexpr size_t historyBuckets = 60; // one hour of per-minute counts
+    static constexpr size_t warmUpBuckets = 10;  // backtest errors before this are not counted
+
+    struct CellSeries {
+        uint32_t cell;
+        uint16_t history[historyBuckets] = {}; // ring buffer of closed buckets
+        size_t head = 0;                       // slot the next closed bucket goes into
+        size_t closed = 0;                     // closed buckets held, up to historyBuckets
+        uint32_t current = 0;                  // bookings in the open bucket
+        double level = 0;
+        double trend = 0;
+    };
+
+    mutex mtx;
+    iClock* clock;
+    GeoLocationManager* geoManager;
+    DriverRatingStore* ratingStore;
+    NotificationEngine* notificationEngine;
+    int64_t bucketMs;
+    int64_t openBucket;
+    unordered_map<uint32_t, size_t> cellIndex;
+    vector<CellSeries> series;
+    thread ticker;
+    atomic<bool> stopping{false};
+
+    static constexpr double alpha = 0.3; // level smoothing
+    static constexpr double beta = 0.1;  // trend smoothing
+
+    // Caller holds mtx. Closes the open bucket of every cell.
+    void rollBucket() {
+        for (auto& s : series) {
+            s.history[s.head] = (uint16_t)min<uint32_t>(s.current, 0xFFFF);
+            s.head = (s.head + 1) % historyBuckets;
+            s.closed = min(s.closed + 1, historyBuckets);
+            double previousLevel = s.level;
+            s.level = alpha * s.current + (1 - alpha) * (s.level + s.trend);
+            s.trend = beta * (s.level - previousLevel) + (1 - beta) * s.trend;
+            s.current = 0;
+        }
+    }
+
+    // Caller holds mtx.
+    double forecastLocked(const CellSeries& s, int horizonBuckets) const {
+        return max(0.0, horizonBuckets * s.level + s.trend * horizonBuckets * (horizonBuckets + 1) / 2.0);
+    }
+
+    // Caller holds mtx. Mean one-bucket-ahead error replayed over the history; 0 until warmed up.
+    double backtestErrorLocked(const CellSeries& s) const {
+        if (s.closed <= warmUpBuckets) return 0;
+        size_t oldest = (s.head + historyBuckets - s.closed) % historyBuckets;
+        double level = 0, trend = 0, error = 0;
+        for (size_t i = 0; i < s.closed; i++) {
+            double actual = s.history[(oldest + i) % historyBuckets];
+            if (i >= warmUpBuckets) error += fabs(actual - max(0.0, level + trend));
+            double previousLevel = level;
+            level = alpha * actual + (1 - alpha) * (level + trend);
+            trend = beta * (level - previousLevel) + (1 - beta) * trend;
+        }
+        return error / (double)(s.closed - warmUpBuckets);
+    }
+
+    // Pairs idle drivers in spare cells with cells short by more than their backtest error.
+    void suggestRepositioning() {
+        vector<pair<uint32_t, double>> deficits;
+        vector<pair<uint32_t, double>> surpluses;
+        unordered_map<uint32_t, vector<string>> idle = ratingStore->idleDriversByCell();
+        {
+            lock_guard<mutex> lock(mtx);
+            for (auto& s : series) {
+                double expected = forecastLocked(s, horizonBuckets);
+                auto it = idle.find(s.cell);
+                double supply = it == idle.end() ? 0 : (double)it->second.size();
+                if (expected - supply >= 1.0 + backtestErrorLocked(s)) deficits.push_back({s.cell, expected - supply});
+            }
+            for (auto& kv : idle) {
+                auto it = cellIndex.find(kv.first);
+                double expected = it == cellIndex.end() ? 0 : forecastLocked(series[it->second], horizonBuckets);
+                if ((double)kv.second.size() - expected >= 1.0) surpluses.push_back({kv.first, kv.second.size() - expected});
+            }
+        }
+        if (deficits.empty() || surpluses.empty()) return;
+        sort(deficits.begin(), deficits.end(), [](auto& a, auto& b) { return a.second > b.second; });
+
+        size_t sent = 0;
+        size_t d = 0;
+        for (auto& surplus : surpluses) {
+            int spare = (int)surplus.second;
+            for (const string& driverName : idle[surplus.first]) {
+                if (spare-- <= 0 || d >= deficits.size() || sent >= maxSuggestionsPerRound) break;
+                GeoPoint target = FleetTable::centerOf(deficits[d].first);
+                char where[32];
+                snprintf(where, sizeof(where), "%.3f,%.3f", target.lat, target.lng);
+                notificationEngine->notifyDriver("High demand expected near " + string(where) + " in the next " +
+                                                 to_string(horizonBuckets) + " minutes. Consider heading there.", driverName);
+                suggestionsSent++;
+                sent++;
+                if (--deficits[d].second < 1.0) d++;
+            }
+        }
+    }
+
+public:
+    int horizonBuckets = 15;
+    size_t maxSuggestionsPerRound = 50;
+    atomic<size_t> suggestionsSent{0};
+
+    DemandForecaster(iClock* clock, GeoLocationManager* gm, DriverRatingStore* rs, NotificationEngine* ne, chrono::milliseconds bucket)
+        : clock(clock), geoManager(gm), ratingStore(rs), notificationEngine(ne), bucketMs(bucket.count()) {
+        openBucket = clock->nowMs() / bucketMs;
+    }
+
+    // Counts the booking against the grid cell of its pickup.
+    void notifyBookingDetails(RideObject* r) override {
+        GeoPoint pickup;
+        if (!geoManager->resolve(r->start, pickup)) return;
+        uint32_t cell = FleetTable::cellOf(pickup);
+        lock_guard<mutex> lock(mtx);
+        auto it = cellIndex.find(cell);
+        if (it == cellIndex.end()) {
+            it = cellIndex.emplace(cell, series.size()).first;
+            series.emplace_back();
+            series.back().cell = cell;
+        }
+        series[it->second].current++;
+    }
+
+    // Rolls every bucket that closed since the last call and then sends suggestions.
+    void tick() {
+        int64_t bucket = clock->nowMs() / bucketMs;
+        {
+            lock_guard<mutex> lock(mtx);
+            if (bucket <= openBucket) return;
+            // A long gap only needs enough empty buckets to flush the ring
+            int64_t missed = min<int64_t>(bucket - openBucket, (int64_t)historyBuckets);
+            for (int64_t i = 0; i < missed; i++) rollBucket();
+            openBucket = bucket;
+        }
+        suggestRepositioning();
+    }
+
+    // Expected bookings starting in the cell over the next horizon buckets.
+    double forecast(uint32_t cell, int horizon) {
+        lock_guard<mutex> lock(mtx);
+        auto it = cellIndex.find(cell);
+        return it == cellIndex.end() ? 0 : forecastLocked(series[it->second], horizon);
+    }
+
+    // How far off the one-bucket-ahead forecast has been for the cell lately.
+    double backtestError(uint32_t cell) {
+        lock_guard<mutex> lock(mtx);
+        auto it = cellIndex.find(cell);
+        return it == cellIndex.end() ? 0 : backtestErrorLocked(series[it->second]);
+    }
+
+    // Live traffic: a background thread checks for a closed bucket every second.
+    void start() {
+        ticker = thread([this] {
+            while (!stopping) {
+                this_thread::sleep_for(chrono::seconds(1));
+                tick();
+            }
+        });
+    }
+
+    void stop() {
+        stopping = true;
+        if (ticker.joinable()) ticker.join();
+    }
+
+    ~DemandForecaster() {
+        stop();
+    }
+};
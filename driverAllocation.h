@@ -0,0 +1,392 @@
+#pragma once
+
+#include "rideLogger.h"
+#include "rideUsers.h"
+#include "geoPoint.h"
+#include "fleetTable.h"
+#include "geoLocation.h"
+#include "rideObject.h"
+#include "geofence.h"
+
+// --------------------- Driver rating store -------------------------
+
+// Decayed rating per driver, plus an index of idle drivers by (cell, vehicle class) ordered by score.
+class DriverRatingStore {
+private:
+    struct Score {
+        double weightedSum = 0;
+        double weight = 0;
+        chrono::steady_clock::time_point lastUpdate;
+    };
+
+    struct Placement {
+        uint32_t cell = FleetTable::noCell;  // grid cell of the last resolvable location
+        uint64_t indexKey = notIndexed;
+        double score = 0;
+    };
+
+    // Pulls drivers with only a few ratings towards the prior, so one 5-star ride
+    // does not outrank a long 4.8 record.
+    static constexpr double priorScore = 4.0;
+    static constexpr double priorWeight = 3.0;
+    static constexpr uint64_t notIndexed = numeric_limits<uint64_t>::max();
+
+    mutex mtx;
+    chrono::milliseconds halfLife;
+    FleetTable* fleet;
+    GeoLocationManager* geoManager;
+    unordered_map<string, Driver*> drivers;
+    unordered_map<string, Score> scores;
+    unordered_map<string, Placement> placements;
+    unordered_map<uint64_t, set<pair<double, string>, greater<pair<double, string>>>> idleIndex;
+
+    static uint64_t indexKeyOf(uint32_t cell, FleetTable::VehicleClass vehicleClass) {
+        return (uint64_t)cell << 8 | vehicleClass;
+    }
+
+    // Resolved outside mtx; the geo manager has its own lock.
+    uint32_t cellOfLocation(const string& location) {
+        GeoPoint p;
+        return geoManager && geoManager->resolve(location, p) ? FleetTable::cellOf(p) : FleetTable::noCell;
+    }
+
+    // Caller holds mtx.
+    double scoreOf(const string& driverName) {
+        auto it = scores.find(driverName);
+        if (it == scores.end()) return priorScore;
+        return (it->second.weightedSum + priorScore * priorWeight) / (it->second.weight + priorWeight);
+    }
+
+    bool claimed(const Driver* d) const {
+        return fleet && fleet->isReserved(d->fleetId);
+    }
+
+    // Caller holds mtx. Moves the driver to the right index bucket (or out of all of them).
+    // A driver claimed for a ride stays out of the index until it is released.
+    void reindex(const string& driverName, uint32_t cell, bool idle) {
+        auto dit = drivers.find(driverName);
+        if (dit == drivers.end()) return;
+        Placement& p = placements[driverName];
+        if (p.indexKey != notIndexed) {
+            auto bucket = idleIndex.find(p.indexKey);
+            bucket->second.erase({p.score, driverName});
+            if (bucket->second.empty()) idleIndex.erase(bucket);
+        }
+        p.cell = cell;
+        p.score = scoreOf(driverName);
+        dit->second->rating = p.score;
+        bool indexed = idle && cell != FleetTable::noCell && !claimed(dit->second);
+        p.indexKey = indexed ? indexKeyOf(cell, FleetTable::classOf(dit->second->vehicleType)) : notIndexed;
+        if (p.indexKey != notIndexed) idleIndex[p.indexKey].insert({p.score, driverName});
+        if (fleet) fleet->setStatus(dit->second->fleetId, dit->second->availability ? FleetTable::Idle : FleetTable::Unavailable, p.score);
+    }
+
+public:
+    // Rings of neighbouring cells claimBestIdle widens to when the pickup cell has nobody.
+    static constexpr int searchRings = 3;
+
+    DriverRatingStore(chrono::milliseconds halfLife, FleetTable* fleet, GeoLocationManager* gm) {
+        this->halfLife = halfLife;
+        this->fleet = fleet;
+        this->geoManager = gm;
+    }
+
+    // Starts tracking a driver at its current location and availability.
+    void registerDriver(Driver* d) {
+        uint32_t cell = cellOfLocation(d->currentLocation);
+        lock_guard<mutex> lock(mtx);
+        if (fleet) fleet->addDriver(d);
+        drivers[d->name] = d;
+        reindex(d->name, cell, d->availability);
+    }
+
+    // Records where a driver is and whether it can take rides; an idle driver is also released.
+    void setDriverState(const string& driverName, const string& location, bool idle) {
+        uint32_t cell = cellOfLocation(location);
+        lock_guard<mutex> lock(mtx);
+        auto dit = drivers.find(driverName);
+        if (dit == drivers.end()) return;
+        dit->second->currentLocation = location;
+        dit->second->availability = idle;
+        if (idle && fleet) fleet->releaseReservation(dit->second->fleetId);
+        reindex(driverName, cell, idle);
+    }
+
+    // A location report: the driver keeps its availability and moves to the new cell.
+    void moveDriver(const string& driverName, const string& location) {
+        uint32_t cell = cellOfLocation(location);
+        lock_guard<mutex> lock(mtx);
+        auto dit = drivers.find(driverName);
+        if (dit == drivers.end()) return;
+        dit->second->currentLocation = location;
+        reindex(driverName, cell, dit->second->availability);
+    }
+
+    // Folds a post-ride rating (1-5) into the score; older ratings halve in weight every halfLife.
+    void ingestRating(const string& driverName, int stars) {
+        if (stars < 1 || stars > 5) return;
+        lock_guard<mutex> lock(mtx);
+        auto now = chrono::steady_clock::now();
+        Score& s = scores[driverName];
+        if (s.weight > 0) {
+            double elapsed = chrono::duration<double, milli>(now - s.lastUpdate).count();
+            double decay = exp2(-elapsed / (double)halfLife.count());
+            s.weightedSum *= decay;
+            s.weight *= decay;
+        }
+        s.weightedSum += stars;
+        s.weight += 1;
+        s.lastUpdate = now;
+
+        auto dit = drivers.find(driverName);
+        if (dit != drivers.end()) reindex(driverName, placements[driverName].cell, dit->second->availability);
+    }
+
+    // Unclaimed idle drivers of every vehicle class, grouped by grid cell.
+    unordered_map<uint32_t, vector<string>> idleDriversByCell() {
+        lock_guard<mutex> lock(mtx);
+        unordered_map<uint32_t, vector<string>> result;
+        for (auto& bucket : idleIndex) {
+            auto& names = result[(uint32_t)(bucket.first >> 8)];
+            for (auto& entry : bucket.second) {
+                if (!claimed(drivers[entry.second])) names.push_back(entry.second);
+            }
+        }
+        return result;
+    }
+
+    // Puts a driver no longer tied to a ride back on the idle index where it last was.
+    void releaseDriver(const string& driverName) {
+        lock_guard<mutex> lock(mtx);
+        auto dit = drivers.find(driverName);
+        if (dit == drivers.end()) return;
+        dit->second->availability = true;
+        if (fleet) fleet->releaseReservation(dit->second->fleetId);
+        reindex(driverName, placements[driverName].cell, true);
+    }
+
+    // Holds off driver state changes, e.g. while a snapshot is taken.
+    unique_lock<mutex> lockState() {
+        return unique_lock<mutex>(mtx);
+    }
+
+    double getRating(const string& driverName) {
+        lock_guard<mutex> lock(mtx);
+        return scoreOf(driverName);
+    }
+
+    // Up to k idle drivers of the class in the cell, best first.
+    vector<string> topK(uint32_t cell, const string& vehicleClass, size_t k) {
+        lock_guard<mutex> lock(mtx);
+        vector<string> result;
+        auto bucket = idleIndex.find(indexKeyOf(cell, FleetTable::classOf(vehicleClass)));
+        if (bucket == idleIndex.end()) return result;
+        for (auto it = bucket->second.begin(); it != bucket->second.end() && result.size() < k; ++it) {
+            if (!claimed(drivers[it->second])) result.push_back(it->second);
+        }
+        return result;
+    }
+
+    // Claims the best idle driver of the class within searchRings cells of the pickup, or "".
+    string claimBestIdle(const GeoPoint& pickup, const string& vehicleClass, const vector<string>& excluded = {}) {
+        return claimBestIdleWhere(pickup, vehicleClass, excluded, [](const GeoPoint&) { return true; });
+    }
+
+    // Same, restricted to drivers whose fleet position passes accept.
+    template <typename Accept>
+    string claimBestIdleWhere(const GeoPoint& pickup, const string& vehicleClass, const vector<string>& excluded, Accept&& accept) {
+        FleetTable::VehicleClass wanted = FleetTable::classOf(vehicleClass);
+        lock_guard<mutex> lock(mtx);
+        while (true) {
+            string best;
+            double bestScore = 0;
+            vector<string> stale;
+            for (int rings = 0; rings <= searchRings && best.empty(); rings++) {
+                for (uint32_t cell : FleetTable::cellsAround(pickup, rings)) {
+                    auto bucket = idleIndex.find(indexKeyOf(cell, wanted));
+                    if (bucket == idleIndex.end()) continue;
+                    for (auto& entry : bucket->second) {
+                        if (find(excluded.begin(), excluded.end(), entry.second) != excluded.end()) continue;
+                        if (claimed(drivers[entry.second])) {
+                            stale.push_back(entry.second);
+                            continue;
+                        }
+                        if (fleet && !accept(fleet->positionOf(drivers[entry.second]->fleetId))) continue;
+                        if (best.empty() || entry.first > bestScore) {
+                            best = entry.second;
+                            bestScore = entry.first;
+                        }
+                        break; // buckets are best first
+                    }
+                }
+            }
+            for (const string& name : stale) reindex(name, placements[name].cell, drivers[name]->availability);
+            if (best.empty()) return "";
+            Driver* d = drivers[best];
+            if (!fleet || fleet->tryReserve(d->fleetId)) {
+                reindex(best, placements[best].cell, d->availability);
+                return best;
+            }
+            // Lost the race to an allocation worker: look again
+        }
+    }
+};
+
+// Keeps the idle index in step with where drivers report in from.
+class idleIndexFeed : public iLocationObserver {
+    DriverRatingStore* ratingStore;
+public:
+    idleIndexFeed(GeoLocationManager* m, DriverRatingStore* rs) : iLocationObserver(m), ratingStore(rs) {}
+
+    void updateLocation(string name, string location, string userType) override {
+        if (userType == "driver") ratingStore->moveDriver(name, location);
+    }
+};
+
+class iDriverAllocationStratergy {
+public:
+    virtual void match(RideObject* r, string drivername) = 0;
+    virtual void getDriver(string uname) = 0;
+    virtual ~iDriverAllocationStratergy() {}
+};
+
+class nearestDriver : public iDriverAllocationStratergy {
+    FleetTable* fleet;
+    GeoLocationManager* gm;
+    GeofenceEngine* geofence; // null: no zone-aware matching
+public:
+    nearestDriver(FleetTable* fleet, GeoLocationManager* gm, GeofenceEngine* geofence) {
+        this->fleet = fleet;
+        this->gm = gm;
+        this->geofence = geofence;
+    }
+
+    void match(RideObject* r, string drivername) override {
+        LOG_INFO("Matching nearest driver...");
+        GeoPoint pickup;
+        if (drivername.empty() && gm->resolve(r->start, pickup)) {
+            vector<uint32_t> skipped;
+            for (const string& name : r->excludedDrivers) {
+                int64_t id = fleet->idOf(name);
+                if (id >= 0) skipped.push_back((uint32_t)id);
+            }
+            // Airport pickups go to a driver already waiting inside the airport zone when there is one
+            bool zoneQueue = geofence && !r->pickupZone.empty();
+            auto inPickupZone = [&](const GeoPoint& driverAt) { return geofence->airportAt(driverAt) == r->pickupZone; };
+            // Allocation workers race for the same drivers; winning the reservation is the claim
+            while (drivername.empty()) {
+                int64_t id = zoneQueue ? fleet->nearestIdleWhere(pickup, FleetTable::classOf(r->vehicleType), skipped, inPickupZone)
+                                       : fleet->nearestIdle(pickup, FleetTable::classOf(r->vehicleType), skipped);
+                if (id < 0 && zoneQueue) {
+                    zoneQueue = false; // nobody in the zone: fall back to the nearest driver anywhere
+                    continue;
+                }
+                if (id < 0) {
+                    LOG_WARN("No idle {} driver near {}.", vehicleClassOf(r->vehicleType), r->start);
+                    return;
+                }
+                if (fleet->tryReserve((uint32_t)id)) {
+                    drivername = fleet->nameOf((uint32_t)id);
+                } else {
+                    skipped.push_back((uint32_t)id);
+                }
+            }
+        } else if (drivername.empty()) {
+            LOG_WARN("Pickup {} is not a known place.", r->start);
+            return;
+        }
+        r->assignDriver(drivername, "confirmed");
+    }
+
+    void getDriver(string uname) override {
+        LOG_INFO("Driver allocated: {}", uname);
+    }
+};
+
+class highestRating : public iDriverAllocationStratergy {
+    DriverRatingStore* ratingStore;
+    GeoLocationManager* gm;
+    GeofenceEngine* geofence; // null: no zone-aware matching
+public:
+    highestRating(DriverRatingStore* rs, GeoLocationManager* gm, GeofenceEngine* geofence) {
+        this->ratingStore = rs;
+        this->gm = gm;
+        this->geofence = geofence;
+    }
+
+    void match(RideObject* r, string drivername) override {
+        LOG_INFO("Matching highest rated driver...");
+        if (drivername.empty()) {
+            // Best-rated idle driver of the requested class around the pickup
+            GeoPoint pickup;
+            if (!gm->resolve(r->start, pickup)) {
+                LOG_WARN("Pickup {} is not a known place.", r->start);
+                return;
+            }
+            // Airport pickups go to the best driver already waiting inside the airport zone when there is one
+            if (geofence && !r->pickupZone.empty()) {
+                drivername = ratingStore->claimBestIdleWhere(pickup, r->vehicleType, r->excludedDrivers, [&](const GeoPoint& driverAt) {
+                    return !isnan(driverAt.lat) && geofence->airportAt(driverAt) == r->pickupZone;
+                });
+            }
+            if (drivername.empty()) drivername = ratingStore->claimBestIdle(pickup, r->vehicleType, r->excludedDrivers);
+            if (drivername.empty()) {
+                LOG_WARN("No idle {} driver near {}.", vehicleClassOf(r->vehicleType), r->start);
+                return;
+            }
+        }
+        r->assignDriver(drivername, "confirmed");
+    }
+
+    void getDriver(string uname) override {
+        LOG_INFO("Driver allocated: {}", uname);
+    }
+};
+
+class rideAllocationFactory {
+public:
+    iDriverAllocationStratergy* st;
+    rideAllocationFactory(iDriverAllocationStratergy* st) {
+        this->st = st;
+    }
+
+    void allocateDriver(RideObject* r) {
+        st->match(r, ""); // Driver name is chosen by strategy, empty string implies strategy will pick
+        if (find(r->excludedDrivers.begin(), r->excludedDrivers.end(), r->driverName) != r->excludedDrivers.end()) {
+            // Strategy came back with a driver who already passed on this ride
+            r->assignDriver("", "pending");
+        }
+    }
+    ~rideAllocationFactory() {
+        delete st;
+    }
+};
+
+// Interface for selecting a driver allocation strategy by name
+class IDriverAllocationStrategySelector {
+public:
+    virtual iDriverAllocationStratergy* selectStrategy(const string& strategyName) = 0;
+    virtual ~IDriverAllocationStrategySelector() {}
+};
+
+class DriverAllocationStrategySelector : public IDriverAllocationStrategySelector {
+    DriverRatingStore* ratingStore;
+    FleetTable* fleet;
+    GeoLocationManager* gm;
+    GeofenceEngine* geofence;
+public:
+    DriverAllocationStrategySelector(DriverRatingStore* rs, FleetTable* fleet, GeoLocationManager* gm, GeofenceEngine* geofence) {
+        this->ratingStore = rs;
+        this->fleet = fleet;
+        this->gm = gm;
+        this->geofence = geofence;
+    }
+
+    iDriverAllocationStratergy* selectStrategy(const string& strategyName) override {
+        if (strategyName == "highestRating") {
+            return new highestRating(ratingStore, gm, geofence);
+        } else {
+            return new nearestDriver(fleet, gm, geofence);
+        }
+    }
+};
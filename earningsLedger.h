@@ -0,0 +1,410 @@
+#pragma once
+
+#include "rideLogger.h"
+#include "rideExecutor.h"
+#include "rideObject.h"
+#include "rideConfig.h"
+
+// ------------------------ Driver earnings and payouts ------------------------
+
+// Credits paid rides to per-thread partials that a merger folds into the day ledger; each
+// finished day is settled into a payout batch file. Amounts are kept in paise.
+// Batch file: Header, one PayoutRecord per driver sorted by name, then the driver names.
+// Unsettled days are saved to payouts-<date>.open.bin on shutdown and read back on start.
+class EarningsLedger {
+public:
+    enum IncentiveBucket { PeakHour, Airport, DailyQuest, incentiveBucketCount };
+
+    struct DriverEarnings {
+        uint32_t rides = 0;
+        int64_t grossPaise = 0;
+        int64_t commissionPaise = 0;
+        int64_t incentivePaise[incentiveBucketCount] = {};
+
+        void add(const DriverEarnings& other) {
+            rides += other.rides;
+            grossPaise += other.grossPaise;
+            commissionPaise += other.commissionPaise;
+            for (int b = 0; b < incentiveBucketCount; b++) incentivePaise[b] += other.incentivePaise[b];
+        }
+
+        int64_t payoutPaise() const {
+            int64_t payout = grossPaise - commissionPaise;
+            for (int b = 0; b < incentiveBucketCount; b++) payout += incentivePaise[b];
+            return payout;
+        }
+    };
+
+private:
+    struct Header {
+        char magic[8];
+        uint32_t version;
+        uint32_t headerSize;
+        int64_t day; // days since 1970-01-01 in settlement time
+        uint64_t driverCount;
+        int64_t grossPaise, commissionPaise, incentivePaise[incentiveBucketCount], payoutPaise;
+        uint64_t recordsOffset, namesOffset, namesSize;
+    };
+
+    struct PayoutRecord {
+        uint32_t nameOffset;
+        uint32_t nameLength;
+        uint32_t rides;
+        uint32_t pad;
+        int64_t grossPaise, commissionPaise, incentivePaise[incentiveBucketCount], payoutPaise;
+    };
+
+    using DayLedger = unordered_map<string, DriverEarnings>;
+
+    struct Partial {
+        mutex mtx;
+        unordered_map<int64_t, DayLedger> days;
+        atomic<bool> retired{false}; // owning thread exited; freed once merged
+    };
+
+    // A thread's partials, one per ledger it has credited; retired when the thread exits.
+    struct ThreadPartials {
+        vector<pair<uint64_t, shared_ptr<Partial>>> held; // ledger instance -> partial
+        ~ThreadPartials() {
+            for (auto& entry : held) entry.second->retired = true;
+        }
+    };
+
+    static constexpr int64_t dayMs = 24 * 60 * 60 * 1000;
+    static constexpr int64_t dayOffsetMs = 330 * 60 * 1000; // settlement days follow IST
+
+    inline static atomic<uint64_t> nextInstanceId{1};
+
+    iClock* clock;
+    ConfigStore* config;
+    string payoutDir;
+    int64_t mergeIntervalMs;
+    uint64_t instanceId;
+
+    mutex registryMtx;
+    vector<shared_ptr<Partial>> partials;
+
+    mutex ledgerMtx;
+    unordered_map<int64_t, DayLedger> ledger; // merged, unsettled days
+    int64_t settledThrough = INT64_MIN;       // last day written out
+
+    thread merger;
+    atomic<bool> stopping{false};
+    bool started = false;
+
+    // The calling thread's partial; a one-entry thread cache keeps the registry off the hot path.
+    Partial* localPartial() {
+        thread_local uint64_t cachedOwner = 0;
+        thread_local Partial* cached = nullptr;
+        thread_local ThreadPartials mine;
+        if (cachedOwner == instanceId) return cached;
+        auto it = find_if(mine.held.begin(), mine.held.end(), [this](auto& entry) { return entry.first == instanceId; });
+        if (it == mine.held.end()) {
+            // Partials of ledgers that no longer exist are only held here
+            erase_if(mine.held, [](auto& entry) { return entry.second.use_count() == 1; });
+            auto p = make_shared<Partial>();
+            {
+                lock_guard<mutex> lock(registryMtx);
+                partials.push_back(p);
+            }
+            mine.held.push_back({instanceId, p});
+            it = mine.held.end() - 1;
+        }
+        cachedOwner = instanceId;
+        cached = it->second.get();
+        return cached;
+    }
+
+    static string dateOf(int64_t day) {
+        chrono::year_month_day ymd{chrono::sys_days{chrono::days{day}}};
+        char buf[16];
+        snprintf(buf, sizeof(buf), "%04d-%02u-%02u", (int)ymd.year(), (unsigned)ymd.month(), (unsigned)ymd.day());
+        return buf;
+    }
+
+    static bool writeBatch(const string& path, int64_t day, const DayLedger& batch) {
+        vector<const pair<const string, DriverEarnings>*> drivers;
+        drivers.reserve(batch.size());
+        for (const auto& kv : batch) drivers.push_back(&kv);
+        sort(drivers.begin(), drivers.end(), [](auto* a, auto* b) { return a->first < b->first; });
+
+        Header h{};
+        memcpy(h.magic, "RIDEPAY1", 8);
+        h.version = 1;
+        h.headerSize = sizeof(Header);
+        h.day = day;
+        h.driverCount = drivers.size();
+        h.recordsOffset = sizeof(Header);
+        h.namesOffset = h.recordsOffset + drivers.size() * sizeof(PayoutRecord);
+
+        vector<PayoutRecord> records;
+        records.reserve(drivers.size());
+        string names;
+        for (auto* kv : drivers) {
+            const DriverEarnings& e = kv->second;
+            PayoutRecord rec{};
+            rec.nameOffset = (uint32_t)names.size();
+            rec.nameLength = (uint32_t)kv->first.size();
+            rec.rides = e.rides;
+            rec.grossPaise = e.grossPaise;
+            rec.commissionPaise = e.commissionPaise;
+            for (int b = 0; b < incentiveBucketCount; b++) {
+                rec.incentivePaise[b] = e.incentivePaise[b];
+                h.incentivePaise[b] += e.incentivePaise[b];
+            }
+            rec.payoutPaise = e.payoutPaise();
+            h.grossPaise += e.grossPaise;
+            h.commissionPaise += e.commissionPaise;
+            h.payoutPaise += rec.payoutPaise;
+            names += kv->first;
+            records.push_back(rec);
+        }
+        h.namesSize = names.size();
+
+        error_code ec;
+        filesystem::create_directories(filesystem::path(path).parent_path(), ec);
+        string tmp = path + ".tmp";
+        ofstream out(tmp, ios::binary | ios::trunc);
+        out.write((const char*)&h, sizeof(h));
+        out.write((const char*)records.data(), (streamsize)(records.size() * sizeof(PayoutRecord)));
+        out.write(names.data(), (streamsize)names.size());
+        out.close();
+        if (!out) return false;
+        filesystem::rename(tmp, path, ec); // a batch appears complete or not at all
+        return !ec;
+    }
+
+    // Reads a batch written by writeBatch; false if the file is missing or malformed.
+    static bool readBatch(const string& path, int64_t& day, DayLedger& batch) {
+        ifstream in(path, ios::binary);
+        if (!in) return false;
+        string data((istreambuf_iterator<char>(in)), istreambuf_iterator<char>());
+        Header h;
+        if (data.size() < sizeof(Header)) return false;
+        memcpy(&h, data.data(), sizeof(Header));
+        if (memcmp(h.magic, "RIDEPAY1", 8) != 0 || h.version != 1 || h.headerSize != sizeof(Header) ||
+            h.recordsOffset > data.size() || h.driverCount > (data.size() - h.recordsOffset) / sizeof(PayoutRecord) ||
+            h.namesOffset > data.size() || h.namesSize > data.size() - h.namesOffset) {
+            return false;
+        }
+        day = h.day;
+        for (uint64_t i = 0; i < h.driverCount; i++) {
+            PayoutRecord rec;
+            memcpy(&rec, data.data() + h.recordsOffset + i * sizeof(PayoutRecord), sizeof(PayoutRecord));
+            if (rec.nameOffset + (uint64_t)rec.nameLength > h.namesSize) return false;
+            DriverEarnings e;
+            e.rides = rec.rides;
+            e.grossPaise = rec.grossPaise;
+            e.commissionPaise = rec.commissionPaise;
+            for (int b = 0; b < incentiveBucketCount; b++) e.incentivePaise[b] = rec.incentivePaise[b];
+            batch[data.substr(h.namesOffset + rec.nameOffset, rec.nameLength)].add(e);
+        }
+        return true;
+    }
+
+    // Folds the open days saved by the previous run back into the ledger.
+    void restoreOpenDays() {
+        error_code ec;
+        for (const auto& entry : filesystem::directory_iterator(payoutDir, ec)) {
+            string name = entry.path().filename().string();
+            if (name.rfind("payouts-", 0) != 0 || !name.ends_with(".open.bin")) continue;
+            int64_t day;
+            DayLedger batch;
+            if (!readBatch(entry.path().string(), day, batch)) {
+                LOG_ERROR("[Earnings] Could not read open day {}; left in place", entry.path().string());
+                continue;
+            }
+            lock_guard<mutex> lock(ledgerMtx);
+            DayLedger& target = ledger[day];
+            for (auto& [driver, e] : batch) target[driver].add(e);
+            LOG_INFO("[Earnings] Reopened {} with {} drivers", dateOf(day), batch.size());
+        }
+    }
+
+    // Merges everything credited so far and writes each unsettled day to its open file.
+    void persistOpenDays() {
+        merge();
+        lock_guard<mutex> lock(ledgerMtx);
+        for (auto& [day, drivers] : ledger) {
+            if (drivers.empty()) continue;
+            string path = openPathFor(day);
+            if (writeBatch(path, day, drivers)) {
+                LOG_INFO("[Earnings] Saved open day {}: {} drivers into {}", dateOf(day), drivers.size(), path);
+            } else {
+                LOG_ERROR("[Earnings] Could not save open day {} to {}", dateOf(day), path);
+            }
+        }
+    }
+
+public:
+    atomic<uint64_t> credited{0};
+
+    EarningsLedger(iClock* clock, ConfigStore* config, string payoutDir, chrono::milliseconds mergeInterval)
+        : clock(clock), config(config), payoutDir(move(payoutDir)), mergeIntervalMs(mergeInterval.count()),
+          instanceId(nextInstanceId.fetch_add(1)) {}
+
+    static int64_t dayOf(int64_t ms) {
+        int64_t shifted = ms + dayOffsetMs;
+        return shifted / dayMs - (shifted % dayMs < 0 ? 1 : 0);
+    }
+
+    string payoutPathFor(int64_t day) const {
+        return payoutDir + "/payouts-" + dateOf(day) + ".bin";
+    }
+
+    string openPathFor(int64_t day) const {
+        return payoutDir + "/payouts-" + dateOf(day) + ".open.bin";
+    }
+
+    // Live traffic: reloads the open days, then merges once per interval and settles days as they end.
+    void start() {
+        restoreOpenDays();
+        started = true;
+        merger = thread([this] {
+            int64_t waitedMs = 0;
+            while (!stopping) {
+                this_thread::sleep_for(chrono::milliseconds(50));
+                waitedMs += 50;
+                if (waitedMs < mergeIntervalMs) continue;
+                waitedMs = 0;
+                settleDueDays();
+            }
+        });
+    }
+
+    // Hot path, called once a payment succeeds.
+    void credit(const RideObject* r) {
+        if (r->driverName.empty() || r->fare <= 0) return;
+        auto cfg = config->snapshot();
+        DriverEarnings e;
+        e.grossPaise = (int64_t)r->fare * 100;
+        e.commissionPaise = (int64_t)r->fare * cfg->commissionPercent; // percent of rupees is paise
+        if (r->rideStatus != "cancelled") { // a late-cancellation fee earns no ride and no incentives
+            e.rides = 1;
+            if (r->pricing == "peak") e.incentivePaise[PeakHour] = (int64_t)cfg->peakIncentive * 100;
+            if (!r->pickupZone.empty() || !r->destZone.empty()) e.incentivePaise[Airport] = (int64_t)cfg->airportIncentive * 100;
+        }
+        int64_t day = dayOf(clock->nowMs());
+
+        Partial* p = localPartial();
+        lock_guard<mutex> lock(p->mtx);
+        p->days[day][r->driverName].add(e);
+        credited.fetch_add(1, memory_order_relaxed);
+    }
+
+    // Folds every partial into the day ledger and frees those of exited threads.
+    void merge() {
+        vector<shared_ptr<Partial>> snapshot;
+        {
+            lock_guard<mutex> lock(registryMtx);
+            snapshot = partials;
+        }
+        vector<Partial*> drained;
+        int64_t today = dayOf(clock->nowMs());
+        lock_guard<mutex> lock(ledgerMtx);
+        for (auto& p : snapshot) {
+            unordered_map<int64_t, DayLedger> days;
+            {
+                if (p->retired) drained.push_back(p.get()); // checked first: nothing is credited after it
+                lock_guard<mutex> partialLock(p->mtx);
+                days.swap(p->days);
+            }
+            for (auto& [day, drivers] : days) {
+                int64_t into = day;
+                if (day <= settledThrough) {
+                    // Paid just before a settlement but merged after it: carried into today's batch
+                    LOG_WARN("[Earnings] {} late credits for settled day {} moved to {}", drivers.size(), dateOf(day), dateOf(today));
+                    into = max(today, settledThrough + 1);
+                }
+                DayLedger& target = ledger[into];
+                for (auto& [driver, e] : drivers) target[driver].add(e);
+            }
+        }
+        if (drained.empty()) return;
+        lock_guard<mutex> registryLock(registryMtx);
+        erase_if(partials, [&](auto& p) { return find(drained.begin(), drained.end(), p.get()) != drained.end(); });
+    }
+
+    // Writes the day's payout batch, with quest bonuses, and drops it from the ledger.
+    bool settleDay(int64_t day) {
+        merge();
+        DayLedger batch;
+        int64_t previouslySettled;
+        {
+            lock_guard<mutex> lock(ledgerMtx);
+            previouslySettled = settledThrough;
+            auto it = ledger.find(day);
+            if (it == ledger.end() && day <= settledThrough) return true; // nothing new; keep the written batch
+            if (it != ledger.end()) {
+                batch.swap(it->second);
+                ledger.erase(it);
+            }
+            settledThrough = max(settledThrough, day);
+        }
+        {
+            auto cfg = config->snapshot();
+            for (auto& [driver, e] : batch) {
+                if (cfg->questRides > 0 && e.rides >= (uint32_t)cfg->questRides) e.incentivePaise[DailyQuest] = (int64_t)cfg->questBonus * 100;
+            }
+        }
+        string path = payoutPathFor(day);
+        if (!writeBatch(path, day, batch)) {
+            LOG_ERROR("[Earnings] Could not write {}; the day stays open for the next attempt", path);
+            lock_guard<mutex> lock(ledgerMtx);
+            for (auto& [driver, e] : batch) {
+                e.incentivePaise[DailyQuest] = 0; // granted again when the retry settles
+                ledger[day][driver].add(e);
+            }
+            settledThrough = previouslySettled;
+            return false;
+        }
+        LOG_INFO("[Earnings] Settled {}: {} drivers into {}", dateOf(day), batch.size(), path);
+        error_code ec;
+        filesystem::remove(openPathFor(day), ec); // now part of the final batch
+        return true;
+    }
+
+    // Settles every day before today that still has earnings. Returns how many were written.
+    size_t settleDueDays() {
+        merge();
+        int64_t today = dayOf(clock->nowMs());
+        vector<int64_t> due;
+        {
+            lock_guard<mutex> lock(ledgerMtx);
+            for (auto& kv : ledger) {
+                if (kv.first < today) due.push_back(kv.first);
+            }
+        }
+        sort(due.begin(), due.end());
+        size_t written = 0;
+        for (int64_t day : due) {
+            if (settleDay(day)) written++;
+        }
+        return written;
+    }
+
+    // Merged earnings so far; credits younger than one merge interval may be missing.
+    DriverEarnings earningsFor(const string& driverName, int64_t day) {
+        lock_guard<mutex> lock(ledgerMtx);
+        auto dit = ledger.find(day);
+        if (dit == ledger.end()) return DriverEarnings{};
+        auto it = dit->second.find(driverName);
+        return it == dit->second.end() ? DriverEarnings{} : it->second;
+    }
+
+    // Merged earnings of every driver over the days not settled yet.
+    DriverEarnings unsettledTotal() {
+        lock_guard<mutex> lock(ledgerMtx);
+        DriverEarnings total;
+        for (auto& [day, drivers] : ledger) {
+            for (auto& kv : drivers) total.add(kv.second);
+        }
+        return total;
+    }
+
+    ~EarningsLedger() {
+        stopping = true;
+        if (merger.joinable()) merger.join();
+        if (started) persistOpenDays();
+    }
+};
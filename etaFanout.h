@@ -0,0 +1,198 @@
+#pragma once
+
+#include "rideLogger.h"
+#include "rideExecutor.h"
+#include "geoPoint.h"
+
+// ------------------------ Pickup ETA fan-out ------------------------
+
+// What a rider's app gets pushed while their driver is on the way or on the trip.
+struct EtaUpdate {
+    string riderName;
+    string driverName;
+    GeoPoint position;
+    int etaSeconds; // -1 when the rider's target is not a known place or coordinate
+    int64_t atMs;
+};
+
+class iEtaObserver {
+public:
+    virtual void onEta(const EtaUpdate& update) = 0;
+    virtual ~iEtaObserver() {}
+};
+
+// Push channel to the rider app; here the updates go to the log.
+class RiderEtaPush : public iEtaObserver {
+public:
+    void onEta(const EtaUpdate& u) override {
+        if (u.etaSeconds < 0) {
+            LOG_INFO("[ETA] {}: driver {} at {},{}", u.riderName, u.driverName, u.position.lat, u.position.lng);
+        } else {
+            LOG_INFO("[ETA] {}: driver {} at {},{}, about {}s away", u.riderName, u.driverName, u.position.lat, u.position.lng, u.etaSeconds);
+        }
+    }
+};
+
+// Riders follow their driver's position and ETA. Ingest only overwrites the latest fix and
+// marks the feed dirty; a flush pass pushes it to the subscribers that are due.
+class EtaFanoutHub {
+    struct Subscriber {
+        string riderName;
+        GeoPoint target;
+        bool hasTarget;
+        int64_t lastPushMs;
+    };
+
+    struct Feed {
+        GeoPoint fix{0, 0};
+        int64_t fixMs = 0;
+        bool hasFix = false;
+        double speedMps = defaultSpeedMps;
+        bool dirty = false;
+        vector<Subscriber> subscribers;
+    };
+
+    struct Shard {
+        mutex mtx;
+        unordered_map<string, Feed> feeds;
+        vector<string> dirty;
+    };
+
+    static constexpr size_t shardCount = 16;
+    static constexpr double defaultSpeedMps = 8.0; // city traffic, about 30 km/h
+    static constexpr double routeFactor = 1.3;     // roads are longer than the straight line
+
+    iClock* clock;
+    iEtaObserver* sink;
+    int64_t minPushIntervalMs;
+    int64_t tickMs;
+    Shard shards[shardCount];
+    thread flusher;
+    atomic<bool> stopping{false};
+
+    Shard& shardFor(const string& driverName) {
+        return shards[hash<string>{}(driverName) % shardCount];
+    }
+
+    // Caller holds the shard lock.
+    static void markDirty(Shard& s, Feed& f, const string& driverName) {
+        if (f.dirty) return;
+        f.dirty = true;
+        s.dirty.push_back(driverName);
+    }
+
+    static int etaSecondsFor(const Feed& f, const Subscriber& sub) {
+        if (!sub.hasTarget) return -1;
+        return (int)llround(distanceMeters(f.fix, sub.target) * routeFactor / f.speedMps);
+    }
+
+public:
+    atomic<uint64_t> published{0};
+    atomic<uint64_t> pushed{0};
+
+    EtaFanoutHub(iClock* clock, iEtaObserver* sink, chrono::milliseconds minPushInterval, chrono::milliseconds tick)
+        : clock(clock), sink(sink), minPushIntervalMs(minPushInterval.count()), tickMs(tick.count()) {}
+
+    // Live traffic: a background thread flushes once per tick.
+    void start() {
+        flusher = thread([this] {
+            while (!stopping) {
+                this_thread::sleep_for(chrono::milliseconds(tickMs));
+                flush();
+            }
+        });
+    }
+
+    // Starts (or retargets) riderName's feed of driverName, seeded with lastFix.
+    void subscribe(const string& riderName, const string& driverName, const GeoPoint* target, const GeoPoint* lastFix) {
+        Shard& s = shardFor(driverName);
+        lock_guard<mutex> lock(s.mtx);
+        Feed& f = s.feeds[driverName];
+        if (lastFix && !f.hasFix) {
+            f.fix = *lastFix;
+            f.fixMs = clock->nowMs();
+            f.hasFix = true;
+        }
+        Subscriber* sub = nullptr;
+        for (Subscriber& existing : f.subscribers) {
+            if (existing.riderName == riderName) sub = &existing;
+        }
+        if (!sub) {
+            f.subscribers.push_back(Subscriber{riderName, GeoPoint{0, 0}, false, INT64_MIN});
+            sub = &f.subscribers.back();
+        }
+        sub->hasTarget = target != nullptr;
+        if (target) sub->target = *target;
+        sub->lastPushMs = INT64_MIN; // the new target is worth an immediate update
+        if (f.hasFix) markDirty(s, f, driverName);
+    }
+
+    void unsubscribe(const string& riderName, const string& driverName) {
+        Shard& s = shardFor(driverName);
+        lock_guard<mutex> lock(s.mtx);
+        auto it = s.feeds.find(driverName);
+        if (it == s.feeds.end()) return;
+        auto& subs = it->second.subscribers;
+        subs.erase(remove_if(subs.begin(), subs.end(), [&](const Subscriber& sub) { return sub.riderName == riderName; }), subs.end());
+        if (subs.empty() && !it->second.dirty) s.feeds.erase(it); // dirty feeds are dropped by the next flush
+    }
+
+    // Ingest side: called for every resolved driver fix. Drivers nobody follows are ignored.
+    void publish(const string& driverName, const GeoPoint& p, int64_t ms) {
+        Shard& s = shardFor(driverName);
+        lock_guard<mutex> lock(s.mtx);
+        auto it = s.feeds.find(driverName);
+        if (it == s.feeds.end()) return;
+        Feed& f = it->second;
+        if (f.hasFix && ms > f.fixMs) {
+            // Smoothed ground speed, kept within what a city car can plausibly do
+            double observed = distanceMeters(f.fix, p) / ((ms - f.fixMs) / 1000.0);
+            f.speedMps = min(max(0.8 * f.speedMps + 0.2 * observed, 3.0), 25.0);
+        }
+        f.fix = p;
+        f.fixMs = ms;
+        f.hasFix = true;
+        markDirty(s, f, driverName);
+        published.fetch_add(1, memory_order_relaxed);
+    }
+
+    // Pushes the newest fix of every dirty feed to the subscribers that are due; returns how many.
+    size_t flush() {
+        int64_t now = clock->nowMs();
+        vector<EtaUpdate> outbox;
+        vector<string> pending;
+        for (Shard& s : shards) {
+            lock_guard<mutex> lock(s.mtx);
+            pending.clear();
+            pending.swap(s.dirty);
+            for (const string& driverName : pending) {
+                auto it = s.feeds.find(driverName);
+                if (it == s.feeds.end()) continue;
+                Feed& f = it->second;
+                f.dirty = false;
+                if (f.subscribers.empty()) {
+                    s.feeds.erase(it);
+                    continue;
+                }
+                bool deferred = false;
+                for (Subscriber& sub : f.subscribers) {
+                    if (sub.lastPushMs != INT64_MIN && now - sub.lastPushMs < minPushIntervalMs) {
+                        deferred = true; // rate limited: the fix is still there next pass
+                        continue;
+                    }
+                    sub.lastPushMs = now;
+                    outbox.push_back(EtaUpdate{sub.riderName, driverName, f.fix, etaSecondsFor(f, sub), now});
+                }
+                if (deferred) markDirty(s, f, driverName);
+            }
+        }
+        for (const EtaUpdate& u : outbox) sink->onEta(u);
+        pushed.fetch_add(outbox.size(), memory_order_relaxed);
+        return outbox.size();
+    }
+
+    ~EtaFanoutHub() {
+        stopping = true;
+        if (flusher.joinable()) flusher.join();
+    }
+};
@@ -0,0 +1,254 @@
+#pragma once
+
+#include "rideUsers.h"
+#include "geoPoint.h"
+
+// ------------------------ Fleet table (structure-of-arrays driver store) ------------------------
+
+// Maps both ride and driver vehicle descriptions ("SUV", "suv", "3-wheeler", "auto")
+// onto one lowercase vehicle class used by the matching indexes.
+inline string vehicleClassOf(string vehicleType) {
+    transform(vehicleType.begin(), vehicleType.end(), vehicleType.begin(), [](unsigned char c) { return tolower(c); });
+    if (vehicleType == "3-wheeler") return "auto";
+    return vehicleType;
+}
+
+// One dense row per driver, one array per attribute; state and vehicle class share a tag
+// byte so "idle SUV" is a single compare, 16 rows at a time.
+// Rows are locked in stripes: a claim or a position update locks only its own stripe,
+// and a scan holds one stripe at a time, so claims never wait for a whole-table scan.
+class FleetTable {
+public:
+    enum DriverState : uint8_t { Unavailable = 0, Idle = 1 };
+    enum VehicleClass : uint8_t { OtherClass = 0, CarClass = 1, SedanClass = 2, SuvClass = 3, AutoClass = 4 };
+
+    static constexpr uint32_t noCell = numeric_limits<uint32_t>::max();
+    static constexpr double cellDegrees = 0.01; // roughly 1.1 km
+    static constexpr uint32_t stripeRows = 1024;
+
+private:
+    mutable shared_mutex mtx;              // the table's shape; held exclusively only to add rows
+    mutable deque<shared_mutex> stripes;   // one per stripeRows rows, guards everything in them
+    vector<float> lats;
+    vector<float> lngs;
+    vector<uint32_t> cells;
+    vector<uint8_t> tags;     // state << 4 | vehicle class; Idle only while online and unclaimed
+    vector<uint8_t> online;   // the driver takes rides, claimed or not
+    vector<uint8_t> reservations; // 1 while the driver is claimed for a ride
+    vector<float> ratings;
+    vector<string> names;
+    unordered_map<string, uint32_t> idsByName;
+
+    static uint8_t tagOf(DriverState state, VehicleClass vehicleClass) {
+        return (uint8_t)((state << 4) | vehicleClass);
+    }
+
+    // Caller holds mtx (shared) and the row's stripe exclusively.
+    void retag(uint32_t id) {
+        DriverState state = online[id] && !reservations[id] ? Idle : Unavailable;
+        tags[id] = tagOf(state, (VehicleClass)(tags[id] & 0x0F));
+    }
+
+    shared_mutex& stripeOf(uint32_t id) const {
+        return stripes[id / stripeRows];
+    }
+
+    // Caller holds mtx (shared). Calls fn(row) for every row whose tag equals wanted, with
+    // that row's stripe held shared.
+    template <typename Fn>
+    void scanTag(uint8_t wanted, Fn&& fn) const {
+        size_t n = tags.size();
+        for (size_t stripeStart = 0; stripeStart < n; stripeStart += stripeRows) {
+            shared_lock<shared_mutex> stripeLock(stripes[stripeStart / stripeRows]);
+            size_t end = min(n, stripeStart + stripeRows);
+            size_t i = stripeStart;
+#ifdef __SSE2__
+            __m128i needle = _mm_set1_epi8((char)wanted);
+            for (; i + 16 <= end; i += 16) {
+                __m128i block = _mm_loadu_si128((const __m128i*)(tags.data() + i));
+                unsigned mask = (unsigned)_mm_movemask_epi8(_mm_cmpeq_epi8(block, needle));
+                while (mask) {
+                    fn((uint32_t)(i + __builtin_ctz(mask)));
+                    mask &= mask - 1;
+                }
+            }
+#endif
+            for (; i < end; i++) {
+                if (tags[i] == wanted) fn((uint32_t)i);
+            }
+        }
+    }
+
+public:
+    atomic<uint64_t> reservationConflicts{0};
+
+    static VehicleClass classOf(const string& vehicleType) {
+        string c = vehicleClassOf(vehicleType);
+        if (c == "car") return CarClass;
+        if (c == "sedan") return SedanClass;
+        if (c == "suv") return SuvClass;
+        if (c == "auto") return AutoClass;
+        return OtherClass;
+    }
+
+    static uint32_t cellOf(const GeoPoint& p) {
+        uint32_t row = (uint32_t)((p.lat + 90.0) / cellDegrees);
+        uint32_t col = (uint32_t)((p.lng + 180.0) / cellDegrees);
+        return row * (uint32_t)(360.0 / cellDegrees) + col;
+    }
+
+    static GeoPoint centerOf(uint32_t cell) {
+        uint32_t cols = (uint32_t)(360.0 / cellDegrees);
+        return GeoPoint{(cell / cols + 0.5) * cellDegrees - 90.0, (cell % cols + 0.5) * cellDegrees - 180.0};
+    }
+
+    // The cell containing p and the ones up to rings cells away from it.
+    static vector<uint32_t> cellsAround(const GeoPoint& p, int rings) {
+        vector<uint32_t> result;
+        for (int dr = -rings; dr <= rings; dr++) {
+            for (int dc = -rings; dc <= rings; dc++) {
+                result.push_back(cellOf(GeoPoint{p.lat + dr * cellDegrees, p.lng + dc * cellDegrees}));
+            }
+        }
+        return result;
+    }
+
+    // The driver's row, created unavailable and without a position if it has none yet.
+    uint32_t addDriver(Driver* d) {
+        unique_lock<shared_mutex> lock(mtx);
+        auto it = idsByName.find(d->name);
+        if (it != idsByName.end()) {
+            d->fleetId = it->second;
+            return it->second;
+        }
+        uint32_t id = (uint32_t)names.size();
+        if (id % stripeRows == 0) stripes.emplace_back();
+        lats.push_back(numeric_limits<float>::quiet_NaN());
+        lngs.push_back(numeric_limits<float>::quiet_NaN());
+        cells.push_back(noCell);
+        tags.push_back(tagOf(Unavailable, classOf(d->vehicleType)));
+        online.push_back(0);
+        reservations.push_back(0);
+        ratings.push_back((float)d->rating);
+        names.push_back(d->name);
+        idsByName[d->name] = id;
+        d->fleetId = id;
+        return id;
+    }
+
+    int64_t idOf(const string& driverName) const {
+        shared_lock<shared_mutex> lock(mtx);
+        auto it = idsByName.find(driverName);
+        return it == idsByName.end() ? -1 : (int64_t)it->second;
+    }
+
+    string nameOf(uint32_t id) const {
+        shared_lock<shared_mutex> lock(mtx);
+        return id < names.size() ? names[id] : "";
+    }
+
+    size_t size() const {
+        shared_lock<shared_mutex> lock(mtx);
+        return names.size();
+    }
+
+    // Last reported position; NaN before the first location update.
+    GeoPoint positionOf(uint32_t id) const {
+        shared_lock<shared_mutex> lock(mtx);
+        if (id >= lats.size()) return GeoPoint{NAN, NAN};
+        shared_lock<shared_mutex> stripeLock(stripeOf(id));
+        return GeoPoint{lats[id], lngs[id]};
+    }
+
+    void setPosition(const string& driverName, const GeoPoint& p) {
+        shared_lock<shared_mutex> lock(mtx);
+        auto it = idsByName.find(driverName);
+        if (it == idsByName.end()) return;
+        unique_lock<shared_mutex> stripeLock(stripeOf(it->second));
+        lats[it->second] = (float)p.lat;
+        lngs[it->second] = (float)p.lng;
+        cells[it->second] = cellOf(p);
+    }
+
+    // Whether the driver takes rides; a claimed driver stays claimed either way.
+    void setStatus(uint32_t id, DriverState state, double rating) {
+        shared_lock<shared_mutex> lock(mtx);
+        if (id >= tags.size()) return;
+        unique_lock<shared_mutex> stripeLock(stripeOf(id));
+        online[id] = state == Idle;
+        ratings[id] = (float)rating;
+        retag(id);
+    }
+
+    // The claim on a driver: workers scan unlocked, then race to reserve; it holds until release.
+    bool tryReserve(uint32_t id) {
+        shared_lock<shared_mutex> lock(mtx);
+        if (id >= reservations.size()) return false;
+        unique_lock<shared_mutex> stripeLock(stripeOf(id));
+        if (reservations[id]) {
+            reservationConflicts.fetch_add(1, memory_order_relaxed);
+            return false;
+        }
+        reservations[id] = 1;
+        retag(id);
+        return true;
+    }
+
+    void releaseReservation(uint32_t id) {
+        shared_lock<shared_mutex> lock(mtx);
+        if (id >= reservations.size()) return;
+        unique_lock<shared_mutex> stripeLock(stripeOf(id));
+        reservations[id] = 0;
+        retag(id);
+    }
+
+    bool isReserved(uint32_t id) const {
+        shared_lock<shared_mutex> lock(mtx);
+        if (id >= reservations.size()) return false;
+        shared_lock<shared_mutex> stripeLock(stripeOf(id));
+        return reservations[id] != 0;
+    }
+
+    // Ids of the unclaimed idle drivers of a class whose position falls in one of the given cells.
+    vector<uint32_t> idleInCells(VehicleClass vehicleClass, const vector<uint32_t>& wantedCells) const {
+        vector<uint32_t> result;
+        if (wantedCells.empty()) return result;
+        // Most candidates are nowhere near the wanted cells; a range check rejects them cheaply
+        auto [lo, hi] = minmax_element(wantedCells.begin(), wantedCells.end());
+        uint32_t minCell = *lo, span = *hi - *lo;
+        shared_lock<shared_mutex> lock(mtx);
+        scanTag(tagOf(Idle, vehicleClass), [&](uint32_t id) {
+            uint32_t c = cells[id];
+            if (c - minCell > span) return; // unsigned: also rejects c < minCell
+            if (find(wantedCells.begin(), wantedCells.end(), c) != wantedCells.end()) result.push_back(id);
+        });
+        return result;
+    }
+
+    // The unclaimed idle driver of the class closest to p (ignoring the excluded ids), or -1.
+    int64_t nearestIdle(const GeoPoint& p, VehicleClass vehicleClass, const vector<uint32_t>& excluded = {}) const {
+        return nearestIdleWhere(p, vehicleClass, excluded, [](const GeoPoint&) { return true; });
+    }
+
+    // Same, restricted to drivers whose position passes accept.
+    template <typename Accept>
+    int64_t nearestIdleWhere(const GeoPoint& p, VehicleClass vehicleClass, const vector<uint32_t>& excluded, Accept&& accept) const {
+        // Equirectangular distance is plenty to rank drivers within a city
+        const float lat = (float)p.lat, lng = (float)p.lng;
+        const float lngScale = (float)cos(p.lat * 3.14159265358979323846 / 180.0);
+        shared_lock<shared_mutex> lock(mtx);
+        int64_t best = -1;
+        float bestD2 = numeric_limits<float>::infinity();
+        scanTag(tagOf(Idle, vehicleClass), [&](uint32_t id) {
+            float dLat = lats[id] - lat;
+            float dLng = (lngs[id] - lng) * lngScale;
+            float d2 = dLat * dLat + dLng * dLng; // NaN for drivers without a position
+            if (d2 < bestD2 && find(excluded.begin(), excluded.end(), id) == excluded.end() &&
+                accept(GeoPoint{lats[id], lngs[id]})) {
+                bestD2 = d2;
+                best = id;
+            }
+        });
+        return best;
+    }
+};
@@ -0,0 +1,394 @@
+#pragma once
+
+#include "rideLogger.h"
+#include "rideExecutor.h"
+#include "geoPoint.h"
+#include "fleetTable.h"
+#include "etaFanout.h"
+
+// ------------------------ GeoLocationManager to manage driver and user location ------------------------
+
+class GeoLocationManager {
+private:
+    // Sessions, or watch callbacks (run under mtx), waiting for a driver to reach a location.
+    struct ArrivalWaiter {
+        string target;
+        coroutine_handle<> handle;
+        RideExecutor* executor;
+        function<void()> onArrival;
+        uint64_t watchId = 0;
+    };
+
+    // Per-driver ingest state: the last two accepted fixes and the trip's delta + varint encoded trail.
+    struct DriverTrack {
+        string lastLocation;
+        int64_t lastAcceptedMs = -1;
+        bool hasFix = false;
+        bool hasPrevFix = false;
+        GeoPoint fix{0, 0};
+        GeoPoint prevFix{0, 0};
+        int64_t fixMs = 0;
+        int64_t prevFixMs = 0;
+        vector<uint8_t> trail;
+        int64_t trailLastMs = 0;
+        int64_t trailLastLatE5 = 0;
+        int64_t trailLastLngE5 = 0;
+        size_t trailPoints = 0;
+        uint32_t jumps = 0; // fixes on this trail implying an impossible speed
+    };
+
+    static constexpr size_t maxTrailPoints = 16384;
+    static constexpr double maxPlausibleSpeedMps = 55; // about 200 km/h
+
+    mutex mtx;
+    iClock* clock;
+    FleetTable* fleet;
+    EtaFanoutHub* etaHub; // null: nobody follows drivers
+    unordered_map<string, vector<ArrivalWaiter>> arrivalWaiters;
+    uint64_t nextWatchId = 1;
+    unordered_map<string, DriverTrack> tracks;
+    unordered_map<string, GeoPoint> places;
+
+    // Caller holds mtx. Hands every waiter whose target was reached back to its executor.
+    void wakeArrivals(const string& driverName, const string& location) {
+        auto it = arrivalWaiters.find(driverName);
+        if (it == arrivalWaiters.end()) return;
+        auto& waiters = it->second;
+        for (size_t i = 0; i < waiters.size();) {
+            if (waiters[i].target == location) {
+                if (waiters[i].onArrival) {
+                    waiters[i].onArrival();
+                } else {
+                    waiters[i].executor->post(waiters[i].handle);
+                }
+                waiters[i] = waiters.back();
+                waiters.pop_back();
+            } else {
+                i++;
+            }
+        }
+        if (waiters.empty()) arrivalWaiters.erase(it);
+    }
+
+    // Caller holds mtx.
+    bool resolveLocked(const string& location, GeoPoint& out) {
+        if (parseGeoPoint(location, out)) return true;
+        auto it = places.find(location);
+        if (it == places.end()) return false;
+        out = it->second;
+        return true;
+    }
+
+    // Caller holds mtx. Records the latest position; keeps the fix only if the driver moved
+    // minMoveMeters (or to another place) or minIntervalMs passed.
+    bool ingestDriverLocation(const string& driverName, const string& location) {
+        driverLocations[driverName] = location;
+        wakeArrivals(driverName, location);
+
+        int64_t now = clock->nowMs();
+        DriverTrack& t = tracks[driverName];
+        GeoPoint p;
+        bool resolved = resolveLocked(location, p);
+        if (resolved && fleet) fleet->setPosition(driverName, p); // matching wants every fix, throttled or not
+        if (resolved && etaHub) etaHub->publish(driverName, p, now); // so do riders following the driver
+        bool accept = t.lastAcceptedMs < 0 || now - t.lastAcceptedMs >= minIntervalMs;
+        if (!accept) {
+            if (resolved && t.hasFix) {
+                accept = distanceMeters(t.fix, p) >= minMoveMeters;
+            } else {
+                accept = location != t.lastLocation;
+            }
+        }
+        if (!accept) return false;
+
+        t.lastLocation = location;
+        t.lastAcceptedMs = now;
+        if (resolved) {
+            if (t.hasFix) {
+                // Fixes closer together than a second are judged as if a second apart
+                double seconds = max<int64_t>(now - t.fixMs, 1000) / 1000.0;
+                if (distanceMeters(t.fix, p) / seconds > maxPlausibleSpeedMps) t.jumps++;
+                t.prevFix = t.fix;
+                t.prevFixMs = t.fixMs;
+                t.hasPrevFix = true;
+            }
+            t.fix = p;
+            t.fixMs = now;
+            t.hasFix = true;
+            appendTrail(t, p, now);
+        }
+        return true;
+    }
+
+    // Caller holds mtx.
+    void appendTrail(DriverTrack& t, const GeoPoint& p, int64_t ms) {
+        if (t.trailPoints >= maxTrailPoints) clearTrail(t);
+        int64_t latE5 = llround(p.lat * 1e5);
+        int64_t lngE5 = llround(p.lng * 1e5);
+        appendVarint(t.trail, (uint64_t)(t.trailPoints == 0 ? ms : ms - t.trailLastMs));
+        appendVarint(t.trail, zigzag(latE5 - t.trailLastLatE5));
+        appendVarint(t.trail, zigzag(lngE5 - t.trailLastLngE5));
+        t.trailLastMs = ms;
+        t.trailLastLatE5 = latE5;
+        t.trailLastLngE5 = lngE5;
+        t.trailPoints++;
+    }
+
+    static void clearTrail(DriverTrack& t) {
+        t.jumps = 0;
+        t.trail.clear();
+        t.trailLastMs = 0;
+        t.trailLastLatE5 = 0;
+        t.trailLastLngE5 = 0;
+        t.trailPoints = 0;
+    }
+
+public:
+    unordered_map<string, string> usersLocations;
+    unordered_map<string, string> driverLocations;
+
+    // Server-side throttle for driver location updates.
+    double minMoveMeters = 25;
+    int64_t minIntervalMs = 5000;
+
+    GeoLocationManager(iClock* clock, FleetTable* fleet, EtaFanoutHub* etaHub) {
+        this->clock = clock;
+        this->fleet = fleet;
+        this->etaHub = etaHub;
+    }
+
+    // Registers a named place so it can be used wherever a coordinate is expected.
+    void addPlace(string name, GeoPoint point) {
+        lock_guard<mutex> lock(mtx);
+        places[name] = point;
+    }
+
+    // Coordinates for a "lat,lng" string or a known place name.
+    bool resolve(const string& location, GeoPoint& out) {
+        if (parseGeoPoint(location, out)) return true; // no shared state needed
+        lock_guard<mutex> lock(mtx);
+        return resolveLocked(location, out);
+    }
+
+    // Returns false when a driver update was throttled off the trail (arrivals still see it).
+    bool storeLocation(string name, string userType, string location) {
+        lock_guard<mutex> lock(mtx);
+        if (userType == "driver") {
+            return ingestDriverLocation(name, location);
+        } else if (userType == "user") {
+            usersLocations[name] = location;
+        }
+        return true;
+    }
+
+    string getDriverLocation(string name) {
+        lock_guard<mutex> lock(mtx);
+        if (driverLocations.find(name) != driverLocations.end()) {
+            return driverLocations[name];
+        } else {
+            return "Driver not found";
+        }
+    }
+
+    void updateDriverLocation(string driverName, string newLocation) {
+        lock_guard<mutex> lock(mtx);
+        if (ingestDriverLocation(driverName, newLocation)) {
+            LOG_INFO("[GeoManager] Driver {} moved to {}", driverName, newLocation);
+        }
+    }
+
+    // Dead reckoning from the last two fixes, for at most maxExtrapolationMs past the last one.
+    bool estimateDriverPosition(const string& driverName, int64_t atMs, GeoPoint& out) {
+        const int64_t maxExtrapolationMs = 30000;
+        lock_guard<mutex> lock(mtx);
+        auto it = tracks.find(driverName);
+        if (it == tracks.end() || !it->second.hasFix) return false;
+        const DriverTrack& t = it->second;
+        out = t.fix;
+        if (!t.hasPrevFix || t.fixMs <= t.prevFixMs) return true;
+        double ahead = (double)min(max<int64_t>(atMs - t.fixMs, 0), maxExtrapolationMs);
+        double span = (double)(t.fixMs - t.prevFixMs);
+        out.lat += (t.fix.lat - t.prevFix.lat) * ahead / span;
+        out.lng += (t.fix.lng - t.prevFix.lng) * ahead / span;
+        return true;
+    }
+
+    // Streams driverName's position and ETA to target (a place or "lat,lng") to the rider.
+    void followDriver(const string& riderName, const string& driverName, const string& target) {
+        if (!etaHub) return;
+        lock_guard<mutex> lock(mtx);
+        GeoPoint targetPoint;
+        bool hasTarget = resolveLocked(target, targetPoint);
+        auto it = tracks.find(driverName);
+        const GeoPoint* lastFix = it != tracks.end() && it->second.hasFix ? &it->second.fix : nullptr;
+        etaHub->subscribe(riderName, driverName, hasTarget ? &targetPoint : nullptr, lastFix);
+    }
+
+    void unfollowDriver(const string& riderName, const string& driverName) {
+        if (etaHub) etaHub->unsubscribe(riderName, driverName);
+    }
+
+    // Holds off location updates, e.g. while a snapshot is taken.
+    unique_lock<mutex> lockState() {
+        return unique_lock<mutex>(mtx);
+    }
+
+    // Starts a fresh trail for the driver, e.g. when a trip begins.
+    void resetTrail(const string& driverName) {
+        lock_guard<mutex> lock(mtx);
+        auto it = tracks.find(driverName);
+        if (it != tracks.end()) clearTrail(it->second);
+    }
+
+    // Decodes the driver's trail into (timestamp ms, point) fixes.
+    vector<pair<int64_t, GeoPoint>> getTrail(const string& driverName) {
+        lock_guard<mutex> lock(mtx);
+        vector<pair<int64_t, GeoPoint>> fixes;
+        auto it = tracks.find(driverName);
+        if (it == tracks.end()) return fixes;
+        const vector<uint8_t>& bytes = it->second.trail;
+        size_t pos = 0;
+        int64_t ms = 0, latE5 = 0, lngE5 = 0;
+        while (pos < bytes.size()) {
+            ms += (int64_t)readVarint(bytes, pos);
+            latE5 += unzigzag(readVarint(bytes, pos));
+            lngE5 += unzigzag(readVarint(bytes, pos));
+            fixes.push_back({ms, GeoPoint{latE5 / 1e5, lngE5 / 1e5}});
+        }
+        return fixes;
+    }
+
+    // Improbable jumps recorded on the driver's trail since it was last reset.
+    uint32_t gpsJumps(const string& driverName) {
+        lock_guard<mutex> lock(mtx);
+        auto it = tracks.find(driverName);
+        return it == tracks.end() ? 0 : it->second.jumps;
+    }
+
+    size_t trailBytes(const string& driverName) {
+        lock_guard<mutex> lock(mtx);
+        auto it = tracks.find(driverName);
+        return it == tracks.end() ? 0 : it->second.trail.size();
+    }
+
+    struct ArrivalAwaiter {
+        GeoLocationManager* gm;
+        RideExecutor* executor;
+        string driverName;
+        string target;
+
+        bool await_ready() { return gm->getDriverLocation(driverName) == target; }
+        bool await_suspend(coroutine_handle<> h) {
+            lock_guard<mutex> lock(gm->mtx);
+            auto it = gm->driverLocations.find(driverName);
+            if (it != gm->driverLocations.end() && it->second == target) return false; // arrived meanwhile
+            gm->arrivalWaiters[driverName].push_back({target, h, executor, nullptr, 0});
+            return true;
+        }
+        void await_resume() {}
+    };
+
+    // Suspends the calling session until the driver's reported location equals target.
+    ArrivalAwaiter arrivalAt(RideExecutor* executor, string driverName, string target) {
+        return ArrivalAwaiter{this, executor, driverName, target};
+    }
+
+    // Calls onArrival once the driver is at target; returns an id for unwatchArrival (0 if already called).
+    uint64_t watchArrival(const string& driverName, const string& target, function<void()> onArrival) {
+        lock_guard<mutex> lock(mtx);
+        auto it = driverLocations.find(driverName);
+        if (it != driverLocations.end() && it->second == target) {
+            onArrival();
+            return 0;
+        }
+        uint64_t id = nextWatchId++;
+        arrivalWaiters[driverName].push_back({target, nullptr, nullptr, move(onArrival), id});
+        return id;
+    }
+
+    // Once this returns the watch's callback is not running and never will.
+    void unwatchArrival(const string& driverName, uint64_t watchId) {
+        lock_guard<mutex> lock(mtx);
+        auto it = arrivalWaiters.find(driverName);
+        if (it == arrivalWaiters.end()) return;
+        auto& waiters = it->second;
+        waiters.erase(remove_if(waiters.begin(), waiters.end(), [watchId](const ArrivalWaiter& w) { return w.watchId == watchId; }),
+                      waiters.end());
+        if (waiters.empty()) arrivalWaiters.erase(it);
+    }
+};
+
+// Place names riders and drivers can use instead of raw coordinates.
+inline void addCityPlaces(GeoLocationManager* gm) {
+    gm->addPlace("Hyderabad", {17.3850, 78.4867});
+    gm->addPlace("Secunderabad", {17.4399, 78.4983});
+    gm->addPlace("Gachibowli", {17.4401, 78.3489});
+    gm->addPlace("HitecCity", {17.4435, 78.3772});
+    gm->addPlace("BanjaraHills", {17.4126, 78.4482});
+    gm->addPlace("Airport", {17.2403, 78.4294});
+}
+
+// ------------------------location Observer Interfaces(polling and socketConnection) ------------------------
+
+class iLocationObserver {
+public:
+    GeoLocationManager* geoManager;
+    iLocationObserver(GeoLocationManager* m) {
+        this->geoManager = m;
+    }
+    virtual void updateLocation(string name, string location, string userType) = 0;
+    virtual ~iLocationObserver() {}
+};
+
+class polling : public iLocationObserver {
+public:
+    polling(GeoLocationManager* m) : iLocationObserver(m) {}
+
+    void updateLocation(string name, string location, string userType) override {
+        if (geoManager->storeLocation(name, userType, location)) {
+            LOG_INFO("[Polling] {} {} is at {}", userType, name, location);
+        }
+    }
+};
+
+class socketConnection : public iLocationObserver {
+public:
+    socketConnection(GeoLocationManager* m) : iLocationObserver(m) {}
+
+    void updateLocation(string name, string location, string userType) override {
+        if (geoManager->storeLocation(name, userType, location)) {
+            LOG_INFO("[Socket] {} {} moved to {}", userType, name, location);
+        }
+    }
+};
+
+// ------------------------ location observable the handle location observer classes ------------------------
+
+class iUserStatus {
+public:
+    vector<iLocationObserver*> observers;
+    virtual void addObserver(iLocationObserver* o) = 0;
+    virtual void removeObserver(iLocationObserver* o) = 0;
+    virtual void notify(string name, string location, string userType) = 0;
+    virtual ~iUserStatus() {} // observers belong to whoever created them
+};
+
+//concrete location observable
+class statusListner : public iUserStatus {
+public:
+    void addObserver(iLocationObserver* o) override {
+        observers.push_back(o);
+    }
+
+    void removeObserver(iLocationObserver* o) override {
+        observers.erase(remove(observers.begin(), observers.end(), o), observers.end());
+    }
+
+    void notify(string name, string location, string userType) override {
+        for (auto& observer : observers) {
+            observer->updateLocation(name, location, userType);
+        }
+    }
+};
+
+//-----------------------ride booking flow-----------------------------
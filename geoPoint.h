@@ -0,0 +1,59 @@
+#pragma once
+
+#include "rideCommon.h"
+
+// ------------------------ Geo points, place names and distances ------------------------
+
+struct GeoPoint {
+    double lat;
+    double lng;
+};
+
+// Great-circle distance in meters.
+inline double distanceMeters(const GeoPoint& a, const GeoPoint& b) {
+    const double earthRadius = 6371000.0;
+    const double toRad = 3.14159265358979323846 / 180.0;
+    double dLat = (b.lat - a.lat) * toRad;
+    double dLng = (b.lng - a.lng) * toRad;
+    double h = sin(dLat / 2) * sin(dLat / 2) + cos(a.lat * toRad) * cos(b.lat * toRad) * sin(dLng / 2) * sin(dLng / 2);
+    return 2 * earthRadius * asin(min(1.0, sqrt(h)));
+}
+
+// Parses "lat,lng" or "lat;lng" (the latter is what CSV traces use).
+inline bool parseGeoPoint(const string& text, GeoPoint& out) {
+    size_t sep = text.find_first_of(",;");
+    if (sep == string::npos) return false;
+    char* end = nullptr;
+    out.lat = strtod(text.c_str(), &end);
+    if (end != text.c_str() + sep) return false;
+    const char* lngStart = text.c_str() + sep + 1;
+    out.lng = strtod(lngStart, &end);
+    return end != lngStart && *end == '\0' && fabs(out.lat) <= 90 && fabs(out.lng) <= 180;
+}
+
+// Variable-length integer coding used by the compressed location trails.
+inline void appendVarint(vector<uint8_t>& out, uint64_t v) {
+    while (v >= 0x80) {
+        out.push_back((uint8_t)(v | 0x80));
+        v >>= 7;
+    }
+    out.push_back((uint8_t)v);
+}
+
+inline uint64_t readVarint(const vector<uint8_t>& in, size_t& pos) {
+    uint64_t v = 0;
+    for (int shift = 0; pos < in.size(); shift += 7) {
+        uint8_t b = in[pos++];
+        v |= (uint64_t)(b & 0x7F) << shift;
+        if (!(b & 0x80)) break;
+    }
+    return v;
+}
+
+inline uint64_t zigzag(int64_t v) {
+    return ((uint64_t)v << 1) ^ (uint64_t)(v >> 63);
+}
+
+inline int64_t unzigzag(uint64_t v) {
+    return (int64_t)(v >> 1) ^ -(int64_t)(v & 1);
+}
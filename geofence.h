@@ -0,0 +1,231 @@
+#pragma once
+
+#include "rideLogger.h"
+#include "geoPoint.h"
+#include "geoLocation.h"
+#include "rideObject.h"
+
+// --------------------- Geofences (service area, airports, restricted zones) -------------------------
+
+// Zone polygons with a grid index; only cells crossed by a boundary need a point-in-polygon test.
+// Zones are read from a text file, one per line:
+//   <service|airport|restricted> <name> <fare adjustment> <lat,lng> <lat,lng> ...
+class GeofenceEngine {
+public:
+    enum ZoneKind : uint8_t { ServiceArea, Airport, Restricted };
+
+    struct Zone {
+        string name;
+        ZoneKind kind;
+        int fareAdjustment; // added to fares starting or ending in the zone
+        vector<GeoPoint> polygon;
+        double minLat, maxLat, minLng, maxLng;
+    };
+
+    static constexpr size_t maxZones = 64; // zone sets are 64-bit masks
+
+private:
+    struct CellZone {
+        uint8_t zone;
+        bool inside; // cell entirely inside the zone; otherwise a boundary runs through it
+    };
+
+    static constexpr double cellDegrees = 0.005; // roughly 550 m
+
+    GeoLocationManager* gm;
+    vector<Zone> zones;
+    uint64_t serviceMask = 0;
+    uint64_t restrictedMask = 0;
+    double originLat = 0, originLng = 0;
+    int rows = 0, cols = 0;
+    vector<uint32_t> cellStart;  // zones of cell i are cellZones[cellStart[i] .. cellStart[i + 1])
+    vector<CellZone> cellZones;
+
+    static bool insidePolygon(const vector<GeoPoint>& poly, const GeoPoint& p) {
+        bool inside = false;
+        for (size_t i = 0, j = poly.size() - 1; i < poly.size(); j = i++) {
+            if ((poly[i].lat > p.lat) != (poly[j].lat > p.lat) &&
+                p.lng < (poly[j].lng - poly[i].lng) * (p.lat - poly[i].lat) / (poly[j].lat - poly[i].lat) + poly[i].lng) {
+                inside = !inside;
+            }
+        }
+        return inside;
+    }
+
+    // Conservative: true whenever an edge's bounding box overlaps the cell.
+    static bool edgeNearCell(const Zone& z, double lat0, double lng0, double lat1, double lng1) {
+        for (size_t i = 0, j = z.polygon.size() - 1; i < z.polygon.size(); j = i++) {
+            const GeoPoint& a = z.polygon[i];
+            const GeoPoint& b = z.polygon[j];
+            if (max(a.lat, b.lat) >= lat0 && min(a.lat, b.lat) <= lat1 && max(a.lng, b.lng) >= lng0 && min(a.lng, b.lng) <= lng1) {
+                return true;
+            }
+        }
+        return false;
+    }
+
+    void buildIndex() {
+        cellStart.assign(1, 0);
+        cellZones.clear();
+        if (zones.empty()) {
+            rows = cols = 0;
+            return;
+        }
+        double minLat = 90, maxLat = -90, minLng = 180, maxLng = -180;
+        for (const Zone& z : zones) {
+            minLat = min(minLat, z.minLat);
+            maxLat = max(maxLat, z.maxLat);
+            minLng = min(minLng, z.minLng);
+            maxLng = max(maxLng, z.maxLng);
+        }
+        originLat = minLat;
+        originLng = minLng;
+        rows = (int)((maxLat - minLat) / cellDegrees) + 1;
+        cols = (int)((maxLng - minLng) / cellDegrees) + 1;
+        for (int r = 0; r < rows; r++) {
+            for (int c = 0; c < cols; c++) {
+                double lat0 = originLat + r * cellDegrees, lng0 = originLng + c * cellDegrees;
+                double lat1 = lat0 + cellDegrees, lng1 = lng0 + cellDegrees;
+                for (size_t zi = 0; zi < zones.size(); zi++) {
+                    const Zone& z = zones[zi];
+                    if (z.maxLat < lat0 || z.minLat > lat1 || z.maxLng < lng0 || z.minLng > lng1) continue;
+                    if (edgeNearCell(z, lat0, lng0, lat1, lng1)) {
+                        cellZones.push_back({(uint8_t)zi, false});
+                    } else if (insidePolygon(z.polygon, GeoPoint{(lat0 + lat1) / 2, (lng0 + lng1) / 2})) {
+                        cellZones.push_back({(uint8_t)zi, true});
+                    }
+                }
+                cellStart.push_back((uint32_t)cellZones.size());
+            }
+        }
+    }
+
+    int firstZone(uint64_t mask) const {
+        return mask ? __builtin_ctzll(mask) : -1;
+    }
+
+public:
+    GeofenceEngine(GeoLocationManager* gm) {
+        this->gm = gm;
+    }
+
+    bool addZone(string name, ZoneKind kind, int fareAdjustment, vector<GeoPoint> polygon) {
+        if (polygon.size() < 3 || zones.size() >= maxZones) return false;
+        Zone z{name, kind, fareAdjustment, polygon, 90, -90, 180, -180};
+        for (const GeoPoint& p : polygon) {
+            z.minLat = min(z.minLat, p.lat);
+            z.maxLat = max(z.maxLat, p.lat);
+            z.minLng = min(z.minLng, p.lng);
+            z.maxLng = max(z.maxLng, p.lng);
+        }
+        if (kind == ServiceArea) serviceMask |= 1ull << zones.size();
+        if (kind == Restricted) restrictedMask |= 1ull << zones.size();
+        zones.push_back(z);
+        buildIndex();
+        return true;
+    }
+
+    // Loads every zone in the file; returns how many were added.
+    int loadFile(const string& path) {
+        ifstream in(path);
+        string line;
+        int added = 0;
+        while (getline(in, line)) {
+            line = line.substr(0, line.find('#'));
+            istringstream fields(line);
+            string kindText, name, point;
+            int fareAdjustment = 0;
+            if (!(fields >> kindText >> name >> fareAdjustment)) continue;
+            ZoneKind kind;
+            if (kindText == "service") {
+                kind = ServiceArea;
+            } else if (kindText == "airport") {
+                kind = Airport;
+            } else if (kindText == "restricted") {
+                kind = Restricted;
+            } else {
+                LOG_ERROR("[Geofence] Rejecting zone {} in {}: unknown kind '{}'", name, path, kindText);
+                continue;
+            }
+            vector<GeoPoint> polygon;
+            GeoPoint p;
+            bool pointsOk = true;
+            while (fields >> point) {
+                if (!parseGeoPoint(point, p)) pointsOk = false;
+                polygon.push_back(p);
+            }
+            if (!pointsOk) {
+                LOG_ERROR("[Geofence] Rejecting zone {} in {}: bad point", name, path);
+                continue;
+            }
+            if (addZone(name, kind, fareAdjustment, polygon)) {
+                added++;
+            } else {
+                LOG_WARN("[Geofence] Skipping zone {} in {}", name, path);
+            }
+        }
+        return added;
+    }
+
+    // Every zone containing p, as a bit per zone index.
+    uint64_t zonesAt(const GeoPoint& p) const {
+        int r = (int)floor((p.lat - originLat) / cellDegrees);
+        int c = (int)floor((p.lng - originLng) / cellDegrees);
+        if (r < 0 || c < 0 || r >= rows || c >= cols) return 0;
+        size_t cell = (size_t)r * cols + c;
+        uint64_t mask = 0;
+        for (uint32_t i = cellStart[cell]; i < cellStart[cell + 1]; i++) {
+            const CellZone& cz = cellZones[i];
+            if (cz.inside || insidePolygon(zones[cz.zone].polygon, p)) mask |= 1ull << cz.zone;
+        }
+        return mask;
+    }
+
+    // Why a point cannot be served, or "" when it can.
+    string checkPoint(const GeoPoint& p) const {
+        uint64_t mask = zonesAt(p);
+        if (serviceMask != 0 && !(mask & serviceMask)) return "outside the service area";
+        if (mask & restrictedMask) return "inside restricted zone " + zones[firstZone(mask & restrictedMask)].name;
+        return "";
+    }
+
+    // The airport zone containing p, or "".
+    string airportAt(const GeoPoint& p) const {
+        uint64_t mask = zonesAt(p) & ~serviceMask & ~restrictedMask;
+        return mask ? zones[firstZone(mask)].name : "";
+    }
+
+    int fareAdjustmentFor(const string& zoneName) const {
+        for (const Zone& z : zones) {
+            if (z.name == zoneName) return z.fareAdjustment;
+        }
+        return 0;
+    }
+
+    // Validates the ride's pickup and destination and tags the airport zones they fall in.
+    // Locations that are neither coordinates nor known places cannot be served.
+    bool tagRide(RideObject* r, string& reason) {
+        GeoPoint pickup, dest;
+        if (!gm->resolve(r->start, pickup)) {
+            reason = "pickup " + r->start + " is not a known place";
+            return false;
+        }
+        reason = checkPoint(pickup);
+        if (!reason.empty()) {
+            reason = "pickup " + reason;
+            return false;
+        }
+        if (!gm->resolve(r->dest, dest)) {
+            reason = "destination " + r->dest + " is not a known place";
+            return false;
+        }
+        reason = checkPoint(dest);
+        if (!reason.empty()) {
+            reason = "destination " + reason;
+            return false;
+        }
+        r->pickupZone = airportAt(pickup);
+        r->destZone = airportAt(dest);
+        return true;
+    }
+};
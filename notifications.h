@@ -0,0 +1,202 @@
+#pragma once
+
+#include "rideLogger.h"
+#include "rideObject.h"
+#include "rideConfig.h"
+
+//notification system/service....................................................................
+//------------------ Strategy ---------------------
+class iNotificationStrategy {
+public:
+    virtual void sendMessage(string message, string recipient, string recipientType) = 0;
+    virtual ~iNotificationStrategy() {}
+};
+
+class Email : public iNotificationStrategy {
+public:
+    void sendMessage(string message, string recipient, string recipientType) override {
+        LOG_INFO("[EMAIL to {} - {}]: {}", recipientType, recipient, message);
+    }
+};
+
+class PushNotification : public iNotificationStrategy {
+public:
+    void sendMessage(string message, string recipient, string recipientType) override {
+        LOG_INFO("[PUSH to {} - {}]: {}", recipientType, recipient, message);
+    }
+};
+
+//------------------ iNotification Interface ---------------------
+class iNotification {
+public:
+    virtual void send(string message, string messageType, RideObject* r) = 0;
+    virtual ~iNotification() {}
+};
+
+//------------------ Base Notification ---------------------
+class BaseNotification : public iNotification {
+protected:
+    iNotificationStrategy* strategy;
+public:
+    BaseNotification(iNotificationStrategy* strategy) {
+        this->strategy = strategy;
+    }
+
+    void send(string message, string messageType, RideObject* r) override {
+        // This base implementation assumes 'r->name' is the primary recipient for the RideObject
+        // Specific decorators/methods will handle notifying drivers if needed.
+        strategy->sendMessage(message, r->name, "user"); // Defaulting to user for this method
+    }
+    virtual ~BaseNotification() {
+        delete strategy;
+    }
+};
+
+//------------------ Decorator ---------------------
+class NotificationDecorator : public iNotification {
+protected:
+    iNotification* wrapped;
+public:
+    NotificationDecorator(iNotification* wrapped) {
+        this->wrapped = wrapped;
+    }
+
+    virtual void send(string message, string messageType, RideObject* r) {
+        wrapped->send(message, messageType, r);
+    }
+    virtual ~NotificationDecorator() {
+        delete wrapped;
+    }
+};
+
+class RideAcceptedNotif : public NotificationDecorator {
+public:
+    RideAcceptedNotif(iNotification* wrapped) : NotificationDecorator(wrapped) {}
+
+    void send(string message, string messageType, RideObject* r) override {
+        // Sent once the driver has accepted the offer (see RideRequestManager::answerOffer)
+        LOG_INFO(">> Ride Accepted Notification Triggered.");
+        wrapped->send("Your ride is accepted by driver " + r->driverName + ". Driver is on the way to " + r->start, "rideAccepted", r);
+        r->setStatus("driver_on_the_way");
+    }
+};
+
+//------------------ Observer Pattern ---------------------
+class iNotificationObserver {
+public:
+    virtual void update(string message, string recipient) = 0;
+    virtual ~iNotificationObserver() {}
+};
+
+class UserNotificationObserver : public iNotificationObserver {
+public:
+    void update(string message, string recipient) override {
+        LOG_INFO("[User Observer] Notified {}: {}", recipient, message);
+    }
+};
+
+class DriverNotificationObserver : public iNotificationObserver {
+public:
+    void update(string message, string recipient) override {
+        LOG_INFO("[Driver Observer] Notified {}: {}", recipient, message);
+    }
+};
+
+class NotificationSubject {
+    vector<iNotificationObserver*> observers;
+public:
+    void addObserver(iNotificationObserver* obs) {
+        observers.push_back(obs);
+    }
+
+    void notifyAll(string message, string recipient) {
+        for (auto& obs : observers) {
+            obs->update(message, recipient);
+        }
+    }
+};
+
+//------------------ Factory ---------------------
+class NotificationFactory {
+public:
+    static iNotification* createNotification(string eventType, iNotificationStrategy* strategy) {
+        iNotification* base = new BaseNotification(strategy);
+        if (eventType == "rideAccepted") {
+            return new RideAcceptedNotif(base); // the decorator owns base
+        }
+        // driverArrived, rideCompleted, custom_message, driver_notification and
+        // user_notification go out through the base notification, possibly with a custom message
+        return base;
+    }
+};
+
+//------------------ Notification Engine ---------------------
+class NotificationEngine {
+private:
+    NotificationSubject* subject;
+    ConfigStore* config;
+
+    static iNotificationStrategy* channelFor(const string& channel) {
+        if (channel == "push") return new PushNotification();
+        return new Email();
+    }
+
+public:
+    NotificationEngine(NotificationSubject* subject, ConfigStore* config) {
+        this->subject = subject;
+        this->config = config;
+    }
+
+    void notify(string eventType, RideObject* r, string customMessage = "") {
+        iNotificationStrategy* strategy = channelFor(config->snapshot()->rideEventChannel); // email unless configured otherwise
+
+        iNotification* notif = NotificationFactory::createNotification(eventType, strategy);
+
+        string messageToUse = customMessage.empty() ? "Ride event occurred" : customMessage;
+
+        if (eventType == "rideAccepted") {
+            notif->send(messageToUse, eventType, r); // RideAcceptedNotif handles specific logic
+        } else if (eventType == "driverArrived") {
+            notif->send(messageToUse, eventType, r); // Sends to user by default via BaseNotification (r->name)
+            subject->notifyAll("Observer: Driver " + r->driverName + " has arrived at " + r->start, r->name);
+        } else if (eventType == "rideCompleted") {
+            notif->send(messageToUse, eventType, r); // Sends to user by default via BaseNotification (r->name)
+            subject->notifyAll("Observer: Your ride with " + r->driverName + " to " + r->dest + " is completed.", r->name);
+            // Driver notification is handled by a separate notifyDriver call from RideManager.
+        } else if (eventType == "custom_message") { // Generic custom message to user
+             notif->send(messageToUse, eventType, r); // Sends to user by default via BaseNotification (r->name)
+             subject->notifyAll("Observer: " + messageToUse, r->name);
+        } else {
+            notif->send(messageToUse, eventType, r);
+            subject->notifyAll("Observer: " + messageToUse, r->name);
+        }
+
+        delete notif;
+    }
+
+    //directly notifying the driver
+    void notifyDriver(string message, string driverName) {
+        iNotificationStrategy* strategy = channelFor(config->snapshot()->driverChannel); // drivers default to push
+        iNotification* notif = new BaseNotification(strategy); // Simple base notification
+
+        // Create a dummy RideObject just to satisfy BaseNotification::send signature.
+        // The actual recipient targeting is done via NotificationSubject's notifyAll.
+        RideObject dummy_ride_for_driver_notif("", "", driverName);
+        notif->send(message, "driver_notification", &dummy_ride_for_driver_notif); // BaseNotification will send to dummy_ride_for_driver_notif.name
+
+        subject->notifyAll("Observer: " + message, driverName); // This is the actual notification to driver observer
+        delete notif;
+    }
+
+    // For directly notifying a user with a non-ride specific message
+    void notifyUser(string message, string userName) {
+        iNotificationStrategy* strategy = channelFor(config->snapshot()->userChannel); // users default to push
+        iNotification* notif = new BaseNotification(strategy);
+
+        RideObject dummy_ride_for_user_notif("", "", userName);
+        notif->send(message, "user_notification", &dummy_ride_for_user_notif); // BaseNotification will send to dummy_ride_for_user_notif.name
+
+        subject->notifyAll("Observer: " + message, userName); // This is the actual notification to user observer
+        delete notif;
+    }
+};
@@ -0,0 +1,98 @@
+#pragma once
+
+#include "rideObject.h"
+#include "geofence.h"
+#include "rideConfig.h"
+
+// ----------------------price calculation for a fare-----------------------
+class iPriceInterface {
+public:
+    virtual int calculate(RideObject* r) = 0;
+    virtual ~iPriceInterface() {}
+};
+
+class normalPrice : public iPriceInterface {
+    int base;
+public:
+    normalPrice(int base) {
+        this->base = base;
+    }
+
+    int calculate(RideObject* r) override {
+        cout << "Normal pricing applied.\n";
+        return base;
+    }
+};
+
+class peakHours : public iPriceInterface {
+    int base;
+    int peakSurcharge;
+public:
+    peakHours(int base, int peakSurcharge) {
+        this->base = base;
+        this->peakSurcharge = peakSurcharge;
+    }
+
+    int calculate(RideObject* r) override {
+        cout << "Peak hour pricing applied.\n";
+        return base + peakSurcharge;
+    }
+};
+
+// Now this is a pure strategy executor, not responsible for creating the strategy
+class PriceStrategy {
+public:
+    iPriceInterface* p;
+
+    // PriceStrategy no longer owns 'p', it's injected
+    PriceStrategy(iPriceInterface* p_strategy) {
+        this->p = p_strategy;
+    }
+
+    int calFare(RideObject* r) {
+        return p->calculate(r);
+    }
+};
+
+// New Interface for Price Calculation, to be injected into BookingManager
+class IPriceCalculator {
+public:
+    virtual int calculateFare(RideObject* r) = 0;
+    virtual ~IPriceCalculator() {}
+};
+
+class ConcretePriceCalculator : public IPriceCalculator {
+    ConfigStore* config;
+    GeofenceEngine* geofence; // null: no zone fare rules
+public:
+    ConcretePriceCalculator(ConfigStore* config, GeofenceEngine* geofence) {
+        this->config = config;
+        this->geofence = geofence;
+    }
+
+    int calculateFare(RideObject* r) override {
+        // Fare table of the config version current when the fare is computed
+        auto cfg = config->snapshot();
+        iPriceInterface* pricing;
+        if (cfg->pricing == "peak") {
+            pricing = new peakHours(cfg->baseFare, cfg->peakSurcharge);
+        } else {
+            pricing = new normalPrice(cfg->baseFare);
+        }
+        PriceStrategy strategy(pricing);
+        int fare = strategy.calFare(r);
+        delete pricing;
+        r->pricing = cfg->pricing;
+
+        // Zone rules, e.g. an airport access fee, for each end of the trip
+        if (geofence) {
+            for (const string& zone : {r->pickupZone, r->destZone}) {
+                if (zone.empty()) continue;
+                int adjustment = geofence->fareAdjustmentFor(zone);
+                cout << zone << " zone fare adjustment applied: " << adjustment << "\n";
+                fare += adjustment;
+            }
+        }
+        return fare;
+    }
+};
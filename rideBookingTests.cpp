@@ -0,0 +1,602 @@
+#include "rideLogger.h"
+#include "rideUsers.h"
+#include "rideExecutor.h"
+#include "geoPoint.h"
+#include "fleetTable.h"
+#include "etaFanout.h"
+#include "geoLocation.h"
+#include "rideObject.h"
+#include "rideIdentity.h"
+#include "rideTimeouts.h"
+#include "geofence.h"
+#include "bookingFactories.h"
+#include "rideConfig.h"
+#include "priceCalculator.h"
+#include "bookingSubject.h"
+#include "driverAllocation.h"
+#include "notifications.h"
+#include "allocationOrchestrator.h"
+#include "riskScoring.h"
+#include "earningsLedger.h"
+#include "rideSession.h"
+#include "allocationWorkers.h"
+#include "admission.h"
+#include "rideRequests.h"
+#include "snapshotStore.h"
+
+// ------------------------ Allocation throughput benchmark ------------------------
+
+// rideBookingTests --bench-alloc [rides] [drivers]
+// Fires a burst of bookings, mostly from one venue, at 1 to 32 allocation workers and reports throughput.
+int runAllocationBench(size_t rideCount, size_t driverCount) {
+    AsyncLogger::instance().setMinLevel(LOG_LEVEL_ERROR);
+    const GeoPoint venue{17.4401, 78.3489}; // Gachibowli stadium
+    const char* driverTypes[] = {"SUV", "Sedan", "3-wheeler"};
+    const char* rideTypes[][2] = {{"car", "suv"}, {"car", "sedan"}, {"auto", "auto"}};
+
+    mt19937 rng(42);
+    uniform_real_distribution<double> city(-0.15, 0.15);
+    normal_distribution<double> crowd(0.0, 0.004);
+    auto pointText = [](const GeoPoint& p) {
+        char buf[48];
+        snprintf(buf, sizeof(buf), "%.5f,%.5f", p.lat, p.lng);
+        return string(buf);
+    };
+    vector<string> driverSpots;
+    for (size_t i = 0; i < driverCount; i++) {
+        driverSpots.push_back(pointText({venue.lat + city(rng), venue.lng + city(rng)}));
+    }
+    vector<GeoPoint> pickups;
+    for (size_t i = 0; i < rideCount; i++) {
+        bool fromVenue = i % 10 < 7; // the stadium empties; the rest of the city keeps booking
+        pickups.push_back(fromVenue ? GeoPoint{venue.lat + crowd(rng), venue.lng + crowd(rng)}
+                                    : GeoPoint{venue.lat + city(rng), venue.lng + city(rng)});
+    }
+
+    cout << "Allocating " << rideCount << " rides over " << driverCount << " drivers ("
+         << thread::hardware_concurrency() << " hardware threads)\n";
+    double baseline = 0;
+    for (int workerCount : {1, 2, 4, 8, 16, 32}) {
+        SystemClock clock;
+        FleetTable fleet;
+        GeoLocationManager gm(&clock, &fleet, nullptr);
+        DriverRatingStore ratingStore(chrono::hours(24 * 30), &fleet, &gm);
+        NotificationSubject notifSubject;
+        ConfigStore config;
+        NotificationEngine notifEngine(&notifSubject, &config);
+        DriverAllocationStrategySelector strategySelector(&ratingStore, &fleet, &gm, nullptr);
+        ConcreteDriverAllocationOrchestrator orchestrator(&notifEngine, &strategySelector);
+
+        vector<Driver*> drivers;
+        for (size_t i = 0; i < driverCount; i++) {
+            Driver* d = new Driver("d" + to_string(i), driverTypes[i % 3]);
+            d->availability = true;
+            drivers.push_back(d);
+            ratingStore.registerDriver(d);
+            gm.storeLocation(d->name, d->userType, driverSpots[i]);
+        }
+        vector<RideObject*> rides;
+        for (size_t i = 0; i < rideCount; i++) {
+            rides.push_back(new RideObject(pointText(pickups[i]), "Airport", "u" + to_string(i), rideTypes[i % 3][0], rideTypes[i % 3][1]));
+        }
+
+        uint64_t steals;
+        auto start = chrono::steady_clock::now();
+        {
+            AllocationWorkerPool pool(workerCount);
+            for (size_t i = 0; i < rideCount; i++) {
+                RideObject* r = rides[i];
+                pool.submit(FleetTable::cellOf(pickups[i]), [&orchestrator, r] { orchestrator.orchestrate(r); });
+            }
+            pool.drain();
+            steals = pool.steals.load();
+        }
+        double seconds = chrono::duration<double>(chrono::steady_clock::now() - start).count();
+
+        // Optimistic reservation must never hand one driver to two rides
+        size_t matched = 0;
+        unordered_map<string, int> assignments;
+        for (RideObject* r : rides) {
+            if (r->driverName.empty()) continue;
+            matched++;
+            assignments[r->driverName]++;
+        }
+        bool unique = assignments.size() == matched;
+
+        double perSecond = rideCount / seconds;
+        if (baseline == 0) baseline = perSecond;
+        cout << "  workers=" << workerCount << " rides/s=" << (uint64_t)perSecond << " speedup=" << perSecond / baseline
+             << "x matched=" << matched << " steals=" << steals << " reservation conflicts=" << fleet.reservationConflicts.load()
+             << (unique ? "" : " DOUBLE-BOOKED DRIVERS") << "\n";
+
+        for (RideObject* r : rides) delete r;
+        for (Driver* d : drivers) delete d;
+        if (!unique) return 1;
+    }
+    return 0;
+}
+
+// ------------------------ Concurrent stress run ------------------------
+
+// Recorded throughput, one "<rides> <threads> <rides/s>" line per configuration.
+const char* stressBaselinePath = "stressBaseline.txt";
+// Share of the recorded rate a run must reach; run-to-run noise stays well above it
+constexpr double stressBaselineFloor = 0.5;
+
+// The baseline only means something for the build it was recorded with: optimized, no sanitizers
+#if defined(__has_feature)
+#if __has_feature(address_sanitizer) || __has_feature(thread_sanitizer)
+#define RIDE_SANITIZED 1
+#endif
+#endif
+#if defined(__OPTIMIZE__) && !defined(__SANITIZE_ADDRESS__) && !defined(__SANITIZE_THREAD__) && !defined(RIDE_SANITIZED)
+constexpr bool stressBuildIsMeasured = true;
+#else
+constexpr bool stressBuildIsMeasured = false;
+#endif
+
+// The recorded rides/s for this ride and thread count, or 0 if there is none.
+double recordedStressRate(size_t rideCount, size_t threadCount) {
+    ifstream in(stressBaselinePath);
+    string line;
+    while (getline(in, line)) {
+        istringstream fields(line.substr(0, line.find('#')));
+        size_t rides, threads;
+        double rate;
+        if (fields >> rides >> threads >> rate && rides == rideCount && threads == threadCount) return rate;
+    }
+    return 0;
+}
+
+// Replaces the entry for this ride and thread count, keeping every other line.
+bool recordStressRate(size_t rideCount, size_t threadCount, double rate) {
+    vector<string> lines;
+    {
+        ifstream in(stressBaselinePath);
+        string line;
+        while (getline(in, line)) {
+            istringstream fields(line.substr(0, line.find('#')));
+            size_t rides, threads;
+            if (fields >> rides >> threads && rides == rideCount && threads == threadCount) continue;
+            lines.push_back(line);
+        }
+    }
+    ofstream out(stressBaselinePath, ios::trunc);
+    for (const string& line : lines) out << line << "\n";
+    out << rideCount << " " << threadCount << " " << (uint64_t)rate << "\n";
+    return (bool)out;
+}
+
+// rideBookingTests --stress [rides] [threads] [min rides/s]
+// Books rides from several threads with retries, cancellations and location updates mixed in,
+// on a virtual clock. Fails on a broken invariant or when throughput drops below the floor.
+int runStressTest(size_t rideCount, size_t threadCount, double minRidesPerSec, double* measuredRidesPerSec = nullptr) {
+    AsyncLogger::instance().setMinLevel(LOG_LEVEL_ERROR);
+    cout.setstate(ios::failbit); // the ride flow narrates every step
+    const GeoPoint center{17.4065, 78.4772};
+    const size_t driverCount = max<size_t>(rideCount / 4, 50);
+    const size_t riderCount = max<size_t>(rideCount / 2, 1); // riders book again, sometimes while still riding
+    auto pointText = [](const GeoPoint& p) {
+        char buf[48];
+        snprintf(buf, sizeof(buf), "%.5f,%.5f", p.lat, p.lng);
+        return string(buf);
+    };
+
+    VirtualClock clock;
+    RideExecutor executor(&clock);
+    FleetTable fleetTable;
+    struct CountingEtaSink : iEtaObserver {
+        atomic<uint64_t> updates{0};
+        void onEta(const EtaUpdate&) override { updates++; }
+    } etaSink;
+    EtaFanoutHub etaHub(&clock, &etaSink, chrono::seconds(1), chrono::milliseconds(5));
+    etaHub.start();
+    GeoLocationManager gm(&clock, &fleetTable, &etaHub);
+    addCityPlaces(&gm);
+    statusListner status;
+    polling pollingObs(&gm);
+    status.addObserver(&pollingObs);
+    NotificationSubject notifSubject;
+    ConfigStore config;
+    NotificationEngine notifEngine(&notifSubject, &config);
+    userManager um;
+    RiskScorer riskScorer(&clock, &gm, &um, chrono::minutes(10));
+    EarningsLedger earnings(&clock, &config, ".", chrono::milliseconds(50)); // merged by the pump, never settled
+    PaymentGateway paymentGateway(&riskScorer, &earnings);
+
+    atomic<size_t> retired{0};
+    mutex statusMtx;
+    unordered_map<string, size_t> endStatuses;
+    int64_t paidFares = 0, paidRides = 0, cancellationFees = 0; // guarded by statusMtx
+    set<uint64_t> unservedIds;             // rides that ended without a trip; their key may be reused
+    ActiveRideIndex activeRides([&](RideObject* r) {
+        {
+            lock_guard<mutex> lock(statusMtx);
+            endStatuses[r->rideStatus]++;
+            if (r->rideStatus == "pending" || r->rideStatus == "cancelled") unservedIds.insert(r->rideId);
+            if (r->rideStatus == "paid") {
+                paidFares += r->fare;
+                paidRides++;
+            }
+            if (r->rideStatus == "cancelled" && !r->freeCancellation) cancellationFees += r->fare;
+        }
+        retired++;
+        delete r;
+    });
+    RideIdGenerator rideIds(1);
+    IdempotencyCache idempotencyCache(chrono::minutes(10), &clock);
+    RideTimeoutManager timeouts(&clock, chrono::milliseconds(5));
+    timeouts.start();
+    DriverRatingStore ratingStore(chrono::hours(24 * 30), &fleetTable, &gm);
+    idleIndexFeed idleFeed(&gm, &ratingStore);
+    status.addObserver(&idleFeed);
+    DriverAllocationStrategySelector strategySelector(&ratingStore, &fleetTable, &gm, nullptr);
+    ConcreteDriverAllocationOrchestrator orchestrator(&notifEngine, &strategySelector, &config);
+    AllocationWorkerPool workers(threadCount);
+    RideRequestManager rideRequestManager(&notifEngine, &gm, &paymentGateway, &orchestrator, &executor,
+                                          &activeRides, &idempotencyCache, &ratingStore, &timeouts, &workers);
+    rideRequestManager.apps.lapsedOfferPercent = 10; // the accept deadline and no-show timeout get their say
+    rideRequestManager.apps.noShowPercent = 5;
+    RideTypeFactorySelector rideTypeSelector;
+    VehicleFactorySelector vehicleSelector;
+    ConcretePriceCalculator priceCalc(&config, nullptr);
+    BookingSubject* bookingSubject = new BookingSubject();
+    bookingSubject->addObservers(&riskScorer);
+    bookingSubject->addObservers(&rideRequestManager); // hands the ride over, so last
+    BookingManager bm(&rideTypeSelector, &vehicleSelector, &priceCalc, bookingSubject,
+                      &rideIds, &idempotencyCache, &activeRides, nullptr, nullptr);
+
+    driverManager dm;
+    const char* driverTypes[] = {"SUV", "Sedan", "3-wheeler"};
+    const char* vehicles[] = {"suv", "sedan", "auto"};
+    mt19937 setupRng(7);
+    uniform_real_distribution<double> city(-0.08, 0.08);
+    for (size_t i = 0; i < driverCount; i++) {
+        Driver* d = new Driver("d" + to_string(i), driverTypes[i % 3]);
+        d->availability = true;
+        dm.addDriver(d);
+        ratingStore.registerDriver(d);
+        status.notify(d->name, pointText({center.lat + city(setupRng), center.lng + city(setupRng)}), d->userType);
+    }
+    for (size_t i = 0; i < riderCount; i++) {
+        User* u = new User("u" + to_string(i), to_string(9000000000ull + i));
+        um.addUser(u);
+        riskScorer.recordAccount(u);
+    }
+
+    // Sessions sleep on the virtual clock; keep it moving while the load runs
+    atomic<bool> pumping{true};
+    // Checkpoints are taken while rides change state under them
+    const string snapshotPath = (filesystem::temp_directory_path() / "rideStress.snap").string();
+    SnapshotStore snapshots(snapshotPath, &clock, &um, &dm, &gm, &activeRides, &ratingStore);
+    thread pump([&] {
+        for (uint64_t spin = 0; pumping; spin++) {
+            executor.runUntil(clock.nowMs() + 250);
+            if (spin % 64 == 0) earnings.merge();
+            if (spin % 256 == 0) snapshots.checkpoint();
+            this_thread::yield();
+        }
+    });
+
+    atomic<size_t> submitted{0}, admitted{0};
+    mutex retryMtx;
+    vector<uint64_t> reissued; // rides whose retry was served by a new ride, checked once all have ended
+    auto start = chrono::steady_clock::now();
+    vector<thread> bookers;
+    for (size_t t = 0; t < threadCount; t++) {
+        bookers.emplace_back([&, t] {
+            mt19937 rng((unsigned)(1000 + t));
+            uniform_real_distribution<double> spot(-0.08, 0.08);
+            uniform_int_distribution<size_t> anyRider(0, riderCount - 1), anyDriver(0, driverCount - 1);
+            uniform_int_distribution<int> dice(0, 99);
+            for (size_t i = t; i < rideCount; i += threadCount) {
+                string rider = "u" + to_string(anyRider(rng));
+                string pickup = pointText({center.lat + spot(rng), center.lng + spot(rng)});
+                string dest = pointText({center.lat + spot(rng), center.lng + spot(rng)});
+                auto makeRide = [&] {
+                    RideObject* r = new RideObject(pickup, dest, rider);
+                    r->rideType = i % 5 == 0 ? "pooling" : "normal";
+                    r->vehicle = vehicles[i % 3];
+                    r->idempotencyKey = "stress-" + to_string(i);
+                    r->requestedAtMs = clock.nowMs();
+                    return r;
+                };
+                uint64_t id = bm.submitBooking(makeRide());
+                submitted++;
+                if (id != 0) admitted++;
+                int roll = dice(rng);
+                if (roll < 20) {
+                    // A client retry of the same request lands on the same ride, unless that ride
+                    // already ended unserved and released its key
+                    uint64_t again = bm.submitBooking(makeRide());
+                    if (again != 0 && again != id) admitted++;
+                    if (id != 0 && again != 0 && again != id) {
+                        lock_guard<mutex> lock(retryMtx);
+                        reissued.push_back(id);
+                    }
+                } else if (roll < 30) {
+                    rideRequestManager.cancelRide(rider);
+                } else if (roll < 60) {
+                    Driver* d = dm.drivers[anyDriver(rng)];
+                    status.notify(d->name, pointText({center.lat + spot(rng), center.lng + spot(rng)}), d->userType);
+                }
+            }
+        });
+    }
+    for (auto& b : bookers) b.join();
+
+    // Let allocation, sessions, lapsed offers and no-shows run out
+    auto giveUpAt = chrono::steady_clock::now() + chrono::seconds(30);
+    while (activeRides.size() > 0 && chrono::steady_clock::now() < giveUpAt) {
+        workers.drain();
+        this_thread::sleep_for(chrono::milliseconds(5));
+    }
+    pumping = false;
+    pump.join();
+    bool snapshotWritten = snapshots.waitForCheckpoint();
+    error_code removeError;
+    filesystem::remove(snapshotPath, removeError);
+    executor.drain();
+    workers.drain();
+    executor.drain();
+    double seconds = chrono::duration<double>(chrono::steady_clock::now() - start).count();
+    cout.clear();
+    earnings.merge();
+    EarningsLedger::DriverEarnings earned = earnings.unsettledTotal();
+
+    size_t busyDrivers = 0;
+    for (Driver* d : dm.drivers) {
+        if (fleetTable.isReserved(d->fleetId)) busyDrivers++;
+    }
+    size_t unfinished = 0, idMismatches = 0;
+    {
+        lock_guard<mutex> lock(statusMtx);
+        for (uint64_t id : reissued) {
+            if (!unservedIds.count(id)) idMismatches++;
+        }
+        for (auto& kv : endStatuses) {
+            bool terminal = kv.first == "paid" || kv.first == "payment_held" || kv.first == "cancelled" ||
+                            kv.first == "pending";
+            if (!terminal) unfinished += kv.second;
+        }
+    }
+    double ridesPerSec = admitted / seconds;
+    cout << "Stress: " << submitted << " bookings from " << threadCount << " threads, " << admitted << " admitted, "
+         << retired << " retired in " << seconds << " s (" << (uint64_t)ridesPerSec << " rides/s)\n";
+    cout << "  end states:";
+    for (auto& kv : endStatuses) cout << " " << kv.first << "=" << kv.second;
+    cout << "\n  ETA updates pushed: " << etaSink.updates << ", reservation conflicts: " << fleetTable.reservationConflicts << "\n";
+    cout << "  earnings: " << earned.rides << " rides, gross INR " << earned.grossPaise / 100 << ", commission INR "
+         << earned.commissionPaise / 100 << ", driver payout INR " << earned.payoutPaise() / 100 << "\n";
+
+    // One stuck match with a ride queued behind it: shedding starts, then stops once drained.
+    bool shedDuringBurst, shedAfterBurst;
+    {
+        AllocationWorkerPool burstWorkers(1);
+        AdmissionController burstAdmission(&clock, &gm, &burstWorkers);
+        atomic<bool> stuck{false}, unstuck{false};
+        burstWorkers.submit(0, [&] {
+            stuck = true;
+            while (!unstuck) this_thread::sleep_for(chrono::milliseconds(1));
+        });
+        while (!stuck) this_thread::sleep_for(chrono::milliseconds(1));
+        burstWorkers.submit(0, [] {});
+        this_thread::sleep_for(chrono::microseconds(burstAdmission.maxQueueWaitMicros * 2));
+        shedDuringBurst = burstAdmission.overloaded();
+        unstuck = true;
+        burstWorkers.drain();
+        shedAfterBurst = burstAdmission.overloaded();
+    }
+    // Neighbouring keys (cell numbers, say) must keep separate buckets
+    TokenBucketTable oneShot(1, 0);
+    bool keysKeptApart = oneShot.tryTake((uint64_t)0, 0) && oneShot.tryTake((uint64_t)1, 0) && !oneShot.tryTake((uint64_t)1, 0);
+
+    bool ok = true;
+    auto check = [&](bool holds, const string& what) {
+        if (!holds) {
+            cout << "  FAILED: " << what << "\n";
+            ok = false;
+        }
+    };
+    check(retired == admitted, "every admitted ride is retired exactly once (" + to_string(retired) + " of " + to_string(admitted) + ")");
+    check(activeRides.size() == 0, "no ride left in the active index");
+    check(idMismatches == 0, to_string(idMismatches) + " retried submissions got a different ride");
+    check(unfinished == 0, to_string(unfinished) + " rides retired mid-trip");
+    check(busyDrivers == 0, to_string(busyDrivers) + " drivers never released");
+    check(earned.rides == (uint64_t)paidRides && earned.grossPaise == (paidFares + cancellationFees) * 100,
+          "earnings credited " + to_string(earned.rides) + " rides for " + to_string(paidRides) + " paid");
+    check(shedDuringBurst, "bookings admitted while a queued ride waited past the limit");
+    check(!shedAfterBurst, "bookings still shed after the backlog drained");
+    check(snapshotWritten, "the last checkpoint taken under load was not written");
+    check(keysKeptApart, "rate limit keys 0 and 1 share a bucket");
+    check(ridesPerSec >= minRidesPerSec, "throughput below " + to_string((uint64_t)minRidesPerSec) + " rides/s");
+    if (measuredRidesPerSec) *measuredRidesPerSec = ridesPerSec;
+    return ok ? 0 : 1;
+}
+
+// ------------------------ Fuzzing entry point ------------------------
+
+#ifdef RIDE_FUZZ
+// clang++ -std=c++20 -g -O1 -fsanitize=fuzzer,address,undefined -DRIDE_FUZZ rideBookingTests.cpp -o rideFuzz
+// The first byte picks the target: even runs the booking prompts on the input's words,
+// odd drives the ride state machine, one operation per byte pair.
+// Bits 1 and 2 of the first byte make half the drivers ignore offers and half the riders not show up.
+// Runs on a virtual clock, so inputs replay exactly; leftover live rides or claimed drivers abort.
+extern "C" int LLVMFuzzerTestOneInput(const uint8_t* data, size_t size) {
+    if (size == 0) return 0;
+    AsyncLogger::instance().setMinLevel(LOG_LEVEL_ERROR);
+    cout.setstate(ios::failbit);
+
+    VirtualClock clock;
+    RideExecutor executor(&clock);
+    FleetTable fleetTable;
+    struct NullEtaSink : iEtaObserver {
+        void onEta(const EtaUpdate&) override {}
+    } etaSink;
+    EtaFanoutHub etaHub(&clock, &etaSink, chrono::seconds(1), chrono::milliseconds(100));
+    GeoLocationManager gm(&clock, &fleetTable, &etaHub);
+    addCityPlaces(&gm);
+    GeofenceEngine geofence(&gm);
+    geofence.addZone("Hyderabad", GeofenceEngine::ServiceArea, 0, {{17.20, 78.20}, {17.20, 78.70}, {17.60, 78.70}, {17.60, 78.20}});
+    geofence.addZone("Airport", GeofenceEngine::Airport, 100, {{17.225, 78.405}, {17.225, 78.455}, {17.255, 78.455}, {17.255, 78.405}});
+    geofence.addZone("Cantonment", GeofenceEngine::Restricted, 0, {{17.455, 78.500}, {17.455, 78.530}, {17.475, 78.530}, {17.475, 78.500}});
+    statusListner status;
+    polling pollingObs(&gm);
+    status.addObserver(&pollingObs);
+    NotificationSubject notifSubject;
+    ConfigStore config;
+    NotificationEngine notifEngine(&notifSubject, &config);
+    userManager um;
+    RiskScorer riskScorer(&clock, &gm, &um, chrono::minutes(10));
+    PaymentGateway paymentGateway(&riskScorer, nullptr);
+    ActiveRideIndex activeRides;
+    RideIdGenerator rideIds(1);
+    IdempotencyCache idempotencyCache(chrono::seconds(30), &clock);
+    RideTimeoutManager timeouts(&clock, chrono::milliseconds(100));
+    DriverRatingStore ratingStore(chrono::hours(24 * 30), &fleetTable, &gm);
+    idleIndexFeed idleFeed(&gm, &ratingStore);
+    status.addObserver(&idleFeed);
+    DriverAllocationStrategySelector strategySelector(&ratingStore, &fleetTable, &gm, &geofence);
+    ConcreteDriverAllocationOrchestrator orchestrator(&notifEngine, &strategySelector, &config);
+    RideRequestManager rideRequestManager(&notifEngine, &gm, &paymentGateway, &orchestrator, &executor,
+                                          &activeRides, &idempotencyCache, &ratingStore, &timeouts, nullptr);
+    timeouts.noShowTimeout = chrono::minutes(1);
+    rideRequestManager.apps.lapsedOfferPercent = data[0] & 2 ? 50 : 0;
+    rideRequestManager.apps.noShowPercent = data[0] & 4 ? 50 : 0;
+    RideTypeFactorySelector rideTypeSelector;
+    VehicleFactorySelector vehicleSelector;
+    ConcretePriceCalculator priceCalc(&config, &geofence);
+    BookingSubject* bookingSubject = new BookingSubject();
+    bookingSubject->addObservers(&riskScorer);
+    bookingSubject->addObservers(&rideRequestManager);
+    BookingManager bm(&rideTypeSelector, &vehicleSelector, &priceCalc, bookingSubject,
+                      &rideIds, &idempotencyCache, &activeRides, nullptr, &geofence);
+
+    driverManager dm;
+    const char* driverTypes[] = {"SUV", "Sedan", "3-wheeler", "SUV"};
+    const char* spots[] = {"Hyderabad", "Secunderabad", "Gachibowli", "HitecCity", "BanjaraHills", "Airport",
+                           "17.46,78.51", "17.3850,78.4867", "91,200", "nowhere", "", "17.44,78.35"};
+    const size_t spotCount = sizeof(spots) / sizeof(spots[0]);
+    for (int i = 0; i < 4; i++) {
+        Driver* d = new Driver("d" + to_string(i), driverTypes[i]);
+        d->availability = true;
+        dm.addDriver(d);
+        ratingStore.registerDriver(d);
+        status.notify(d->name, spots[i], d->userType);
+    }
+    auto settle = [&](int64_t ms) {
+        executor.runUntil(clock.nowMs() + ms);
+        timeouts.advance();
+        etaHub.flush();
+    };
+
+    if (data[0] % 2 == 0) {
+        // The prompts read whitespace separated words, as they do from the console
+        istringstream answers(string((const char*)data + 1, size - 1));
+        streambuf* console = cin.rdbuf(answers.rdbuf());
+        bm.createBooking();
+        cin.rdbuf(console);
+        cin.clear();
+    } else {
+        const char* vehicles[] = {"sedan", "suv", "auto", ""};
+        string lastRider, lastPickup, lastDest, lastKey;
+        for (size_t i = 1; i + 1 < size; i += 2) {
+            uint8_t op = data[i] % 6, arg = data[i + 1];
+            switch (op) {
+                case 0:
+                case 1: {
+                    // Book, or (op 1) resubmit the previous request under the same key
+                    if (op == 0 || lastKey.empty()) {
+                        lastRider = "u" + to_string(arg % 3);
+                        lastPickup = spots[arg % spotCount];
+                        lastDest = spots[(arg / 3) % spotCount];
+                        lastKey = "fuzz-" + to_string(i);
+                    }
+                    RideObject* r = new RideObject(lastPickup, lastDest, lastRider);
+                    r->rideType = arg & 0x80 ? "pooling" : "normal";
+                    r->vehicle = vehicles[(arg >> 5) & 3];
+                    r->idempotencyKey = lastKey;
+                    r->requestedAtMs = clock.nowMs();
+                    bm.submitBooking(r);
+                    break;
+                }
+                case 2:
+                    rideRequestManager.cancelRide("u" + to_string(arg % 3));
+                    break;
+                case 3:
+                    status.notify("d" + to_string(arg % 4), spots[(arg / 4) % spotCount], Driver::userType);
+                    break;
+                case 4:
+                    ratingStore.ingestRating("d" + to_string(arg % 4), arg % 7);
+                    break;
+                case 5:
+                    settle((int64_t)arg * 100);
+                    break;
+            }
+        }
+    }
+
+    // Run every ride to its end; nothing may be left live or holding a driver
+    // (each round lets one accept deadline or no-show timeout expire)
+    int64_t longestTimeoutMs = max(timeouts.acceptTimeout, timeouts.noShowTimeout).count();
+    for (int round = 0; round < 6; round++) {
+        executor.drain();
+        settle(longestTimeoutMs + 1000);
+    }
+    cout.clear();
+    if (activeRides.size() != 0) abort();
+    for (Driver* d : dm.drivers) {
+        if (fleetTable.isReserved(d->fleetId)) abort();
+    }
+    return 0;
+}
+#endif
+
+// ------------------------ Main ------------------------
+
+#ifndef RIDE_FUZZ // libFuzzer brings its own main
+int main(int argc, char* argv[]) {
+    // rideBookingTests --bench-alloc [rides] [drivers]
+    if (argc >= 2 && string(argv[1]) == "--bench-alloc") {
+        return runAllocationBench(argc >= 3 ? stoul(argv[2]) : 20000, argc >= 4 ? stoul(argv[3]) : 30000);
+    }
+    size_t rideCount = argc >= 3 ? stoul(argv[2]) : 5000;
+    size_t threadCount = argc >= 4 ? stoul(argv[3]) : 4;
+    // rideBookingTests --record-baseline [rides] [threads]: stores the median of three runs
+    if (argc >= 2 && string(argv[1]) == "--record-baseline") {
+        if (!stressBuildIsMeasured) {
+            cerr << "Record the baseline from an optimized build without sanitizers" << endl;
+            return 2;
+        }
+        vector<double> rates(3);
+        for (double& rate : rates) {
+            if (runStressTest(rideCount, threadCount, 0, &rate) != 0) return 1;
+        }
+        sort(rates.begin(), rates.end());
+        if (!recordStressRate(rideCount, threadCount, rates[1])) return 1;
+        cout << "Recorded " << (uint64_t)rates[1] << " rides/s for " << rideCount << " rides on " << threadCount
+             << " threads in " << stressBaselinePath << "\n";
+        return 0;
+    }
+    // rideBookingTests [--stress [rides] [threads] [min rides/s]]
+    if (argc >= 2 && string(argv[1]) != "--stress") {
+        cerr << "usage: rideBookingTests [--stress [rides] [threads] [min rides/s]] | --record-baseline [rides] [threads]"
+                " | --bench-alloc [rides] [drivers]" << endl;
+        return 2;
+    }
+    // The floor is half the recorded rate unless one is given; 0 turns it off
+    double minRidesPerSec = 0;
+    if (argc >= 5) {
+        minRidesPerSec = stod(argv[4]);
+    } else if (stressBuildIsMeasured) {
+        double recorded = recordedStressRate(rideCount, threadCount);
+        if (recorded > 0) {
+            minRidesPerSec = recorded * stressBaselineFloor;
+        } else {
+            cout << "No recorded baseline for " << rideCount << " rides on " << threadCount
+                 << " threads in " << stressBaselinePath << "; throughput is not checked\n";
+        }
+    }
+    return runStressTest(rideCount, threadCount, minRidesPerSec);
+}
+#endif
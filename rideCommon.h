@@ -0,0 +1,46 @@
+#pragma once
+
+#include <iostream>
+#include <vector>
+#include <unordered_map>
+#include <algorithm>
+#include <string>
+#include <cctype>
+#include <thread>
+#include <chrono>
+#include <coroutine>
+#include <mutex>
+#include <condition_variable>
+#include <deque>
+#include <queue>
+#include <atomic>
+#include <set>
+#include <cmath>
+#include <limits>
+#include <fstream>
+#include <string_view>
+#include <charconv>
+#include <functional>
+#include <cstring>
+#include <cstdio>
+#include <ctime>
+#include <type_traits>
+#include <shared_mutex>
+#include <random>
+#include <filesystem>
+#include <sstream>
+#ifdef __SSE2__
+#include <emmintrin.h>
+#endif
+#ifndef _WIN32
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
+#endif
+#ifdef __linux__
+#include <sys/inotify.h>
+#include <poll.h>
+#endif
+
+using namespace std;
@@ -0,0 +1,238 @@
+#pragma once
+
+#include "rideLogger.h"
+
+// ------------------------ Runtime configuration (hot reload) ------------------------
+
+// Fare constants and strategy choices that can change while the service is taking
+// bookings. A published RideConfig is immutable; a reload builds a new one.
+struct RideConfig {
+    uint64_t version = 0;
+    int baseFare = 50;
+    int peakSurcharge = 20;
+    int commissionPercent = 20; // platform share of each fare
+    int peakIncentive = 10;     // per ride priced at peak, INR
+    int airportIncentive = 15;  // per ride starting or ending in an airport zone, INR
+    int questRides = 10;        // rides in a day that earn the daily quest bonus
+    int questBonus = 100;       // INR
+    string pricing = "normal";                  // normal | peak
+    string allocationStrategy = "nearestDriver"; // nearestDriver | highestRating
+    string rideEventChannel = "email";          // channel for ride events: email | push
+    string driverChannel = "push";
+    string userChannel = "push";
+};
+
+// Current RideConfig behind one atomic pointer (RCU style); a superseded version is freed
+// once the readers of its epoch have unpinned.
+// File format: key=value lines, '#' starts a comment; a file that fails to parse is ignored.
+class ConfigStore {
+private:
+    static constexpr size_t readerStripes = 16;
+
+    // Readers pinned in each epoch parity, striped by thread to keep the counts apart
+    struct alignas(64) ReaderCounts {
+        atomic<int64_t> pinned[2] = {0, 0};
+    };
+
+    atomic<const RideConfig*> current{nullptr};
+    mutable ReaderCounts readers[readerStripes];
+    atomic<uint64_t> epoch{0};
+    mutex writerMtx;
+    string path;
+    thread watcher;
+    atomic<bool> stopping{false};
+
+    static int RideConfig::*intField(const string& key) {
+        if (key == "base_fare") return &RideConfig::baseFare;
+        if (key == "peak_surcharge") return &RideConfig::peakSurcharge;
+        if (key == "commission_percent") return &RideConfig::commissionPercent;
+        if (key == "peak_incentive") return &RideConfig::peakIncentive;
+        if (key == "airport_incentive") return &RideConfig::airportIncentive;
+        if (key == "quest_rides") return &RideConfig::questRides;
+        if (key == "quest_bonus") return &RideConfig::questBonus;
+        return nullptr;
+    }
+
+    static bool parse(const string& text, RideConfig& out, string& error) {
+        size_t pos = 0;
+        int lineNo = 0;
+        while (pos < text.size()) {
+            size_t eol = text.find('\n', pos);
+            string line = text.substr(pos, eol == string::npos ? string::npos : eol - pos);
+            pos = eol == string::npos ? text.size() : eol + 1;
+            lineNo++;
+            line = line.substr(0, line.find('#'));
+            size_t eq = line.find('=');
+            auto trim = [](string s) {
+                size_t b = s.find_first_not_of(" \t\r");
+                size_t e = s.find_last_not_of(" \t\r");
+                return b == string::npos ? string() : s.substr(b, e - b + 1);
+            };
+            if (trim(line).empty()) continue;
+            if (eq == string::npos) {
+                error = "line " + to_string(lineNo) + ": expected key=value";
+                return false;
+            }
+            string key = trim(line.substr(0, eq));
+            string value = trim(line.substr(eq + 1));
+            if (int RideConfig::*field = intField(key)) {
+                int v = 0;
+                auto [end, ec] = from_chars(value.data(), value.data() + value.size(), v);
+                if (ec != errc() || end != value.data() + value.size() || v < 0) {
+                    error = "line " + to_string(lineNo) + ": " + key + " must be a non-negative integer";
+                    return false;
+                }
+                if (field == &RideConfig::commissionPercent && v > 100) {
+                    error = "line " + to_string(lineNo) + ": commission_percent must be at most 100";
+                    return false;
+                }
+                out.*field = v;
+            } else if (key == "pricing" && (value == "normal" || value == "peak")) {
+                out.pricing = value;
+            } else if (key == "allocation_strategy" && (value == "nearestDriver" || value == "highestRating")) {
+                out.allocationStrategy = value;
+            } else if ((key == "ride_event_channel" || key == "driver_channel" || key == "user_channel") &&
+                       (value == "email" || value == "push")) {
+                (key == "ride_event_channel" ? out.rideEventChannel : key == "driver_channel" ? out.driverChannel : out.userChannel) = value;
+            } else {
+                error = "line " + to_string(lineNo) + ": unknown key or value '" + key + "=" + value + "'";
+                return false;
+            }
+        }
+        return true;
+    }
+
+    // Caller holds writerMtx. Returns once no reader pinned before the call is left.
+    void waitForReaders() {
+        for (int flip = 0; flip < 2; flip++) {
+            size_t parity = epoch.fetch_add(1) & 1;
+            for (ReaderCounts& r : readers) {
+                while (r.pinned[parity].load() != 0) this_thread::sleep_for(chrono::microseconds(100));
+            }
+        }
+    }
+
+    void publish(RideConfig* next) {
+        const RideConfig* previous = current.load(memory_order_relaxed);
+        next->version = previous ? previous->version + 1 : 1;
+        current.store(next);
+        if (previous) {
+            waitForReaders();
+            delete previous;
+        }
+    }
+
+#ifdef __linux__
+    // Watches the directory rather than the file so editors that save by rename are seen too.
+    bool watchWithInotify() {
+        int fd = inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+        if (fd < 0) return false;
+        size_t slash = path.find_last_of('/');
+        string dir = slash == string::npos ? "." : path.substr(0, slash + 1);
+        string file = slash == string::npos ? path : path.substr(slash + 1);
+        if (inotify_add_watch(fd, dir.c_str(), IN_CLOSE_WRITE | IN_MOVED_TO | IN_CREATE) < 0) {
+            close(fd);
+            return false;
+        }
+        alignas(inotify_event) char buf[4096];
+        while (!stopping) {
+            pollfd pfd{fd, POLLIN, 0};
+            if (poll(&pfd, 1, 200) <= 0) continue;
+            ssize_t n = read(fd, buf, sizeof(buf));
+            bool touched = false;
+            for (char* p = buf; n > 0 && p < buf + n;) {
+                inotify_event* ev = (inotify_event*)p;
+                if (ev->len > 0 && file == ev->name) touched = true;
+                p += sizeof(inotify_event) + ev->len;
+            }
+            if (touched) reload();
+        }
+        close(fd);
+        return true;
+    }
+#endif
+
+    void watchByPolling() {
+        error_code ec;
+        auto lastWrite = filesystem::last_write_time(path, ec);
+        while (!stopping) {
+            this_thread::sleep_for(chrono::milliseconds(500));
+            auto now = filesystem::last_write_time(path, ec);
+            if (!ec && now != lastWrite) {
+                lastWrite = now;
+                reload();
+            }
+        }
+    }
+
+public:
+    // Starts from the built-in defaults, then the file at path if there is one.
+    ConfigStore(string path = "") {
+        this->path = path;
+        publish(new RideConfig());
+        if (!path.empty()) reload();
+    }
+
+    // A pinned version; it is not freed until the Pin goes out of scope.
+    class Pin {
+    private:
+        atomic<int64_t>* counter;
+        const RideConfig* config;
+
+    public:
+        Pin(atomic<int64_t>* counter, const RideConfig* config) : counter(counter), config(config) {}
+        Pin(const Pin&) = delete;
+        Pin& operator=(const Pin&) = delete;
+        ~Pin() {
+            counter->fetch_sub(1, memory_order_release);
+        }
+        const RideConfig* operator->() const {
+            return config;
+        }
+        const RideConfig& operator*() const {
+            return *config;
+        }
+    };
+
+    // Two atomic increments and a load; hold the Pin only for the length of the call.
+    Pin snapshot() const {
+        size_t stripe = hash<thread::id>{}(this_thread::get_id()) % readerStripes;
+        atomic<int64_t>* counter = &readers[stripe].pinned[epoch.load() & 1];
+        counter->fetch_add(1);
+        return Pin(counter, current.load());
+    }
+
+    // Re-reads the file and publishes it as a new version if it parses.
+    bool reload() {
+        ifstream in(path, ios::binary);
+        if (!in) return false;
+        string text((istreambuf_iterator<char>(in)), istreambuf_iterator<char>());
+        lock_guard<mutex> lock(writerMtx);
+        RideConfig* next = new RideConfig(); // unset keys fall back to the defaults
+        string error;
+        if (!parse(text, *next, error)) {
+            delete next;
+            LOG_WARN("[Config] Ignoring {}: {}", path, error);
+            return false;
+        }
+        publish(next);
+        LOG_INFO("[Config] Loaded {} as version {} (pricing={}, strategy={})", path, next->version, next->pricing, next->allocationStrategy);
+        return true;
+    }
+
+    void startWatching() {
+        if (path.empty() || watcher.joinable()) return;
+        watcher = thread([this] {
+#ifdef __linux__
+            if (watchWithInotify()) return;
+#endif
+            watchByPolling();
+        });
+    }
+
+    ~ConfigStore() {
+        stopping = true;
+        if (watcher.joinable()) watcher.join();
+        delete current.load();
+    }
+};
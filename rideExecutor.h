@@ -0,0 +1,259 @@
+#pragma once
+
+#include "rideCommon.h"
+
+// ------------------------ Clocks (wall time for live traffic, virtual time for replays) ------------------------
+
+class iClock {
+public:
+    virtual int64_t nowMs() = 0;
+    virtual ~iClock() {}
+};
+
+// Monotonic milliseconds on the steady clock's epoch.
+class SystemClock : public iClock {
+public:
+    int64_t nowMs() override {
+        return chrono::duration_cast<chrono::milliseconds>(chrono::steady_clock::now().time_since_epoch()).count();
+    }
+};
+
+// Milliseconds since the Unix epoch, for things dated by the calendar (payout days).
+class WallClock : public iClock {
+public:
+    int64_t nowMs() override {
+        return chrono::duration_cast<chrono::milliseconds>(chrono::system_clock::now().time_since_epoch()).count();
+    }
+};
+
+// Time that only moves when the replay driver advances it.
+class VirtualClock : public iClock {
+    atomic<int64_t> now{0};
+public:
+    int64_t nowMs() override {
+        return now.load(memory_order_relaxed);
+    }
+
+    void advanceTo(int64_t t) {
+        if (t > now.load(memory_order_relaxed)) now.store(t, memory_order_relaxed);
+    }
+};
+
+// ------------------------ Ride Executor (coroutine scheduler for live rides) ------------------------
+
+// Fire-and-forget ride session coroutine; starts suspended and frees its own frame.
+class RideExecutor;
+
+struct RideTask {
+    struct promise_type {
+        RideExecutor* executor = nullptr;
+
+        RideTask get_return_object() {
+            return RideTask{coroutine_handle<promise_type>::from_promise(*this)};
+        }
+        suspend_always initial_suspend() noexcept { return {}; }
+
+        struct FinalAwaiter {
+            bool await_ready() noexcept { return false; }
+            void await_suspend(coroutine_handle<promise_type> h) noexcept;
+            void await_resume() noexcept {}
+        };
+        FinalAwaiter final_suspend() noexcept { return {}; }
+
+        void return_void() {}
+        void unhandled_exception() { terminate(); }
+    };
+
+    coroutine_handle<promise_type> handle;
+};
+
+// Small thread pool that resumes suspended ride sessions; a waiting session holds no thread.
+// Over a VirtualClock it runs no threads: runUntil() resumes sessions inline in time order.
+class RideExecutor {
+private:
+    struct TimerEntry {
+        int64_t dueMs;
+        uint64_t seq;
+        coroutine_handle<> handle;
+        bool operator>(const TimerEntry& other) const {
+            return dueMs != other.dueMs ? dueMs > other.dueMs : seq > other.seq;
+        }
+    };
+
+    SystemClock systemClock;
+    iClock* clock;
+    VirtualClock* virtualClock; // null in real-time mode
+    vector<thread> workers;
+    thread timerThread;
+    mutex mtx;
+    condition_variable readyCv;
+    condition_variable timerCv;
+    condition_variable idleCv;
+    deque<coroutine_handle<>> ready;
+    priority_queue<TimerEntry, vector<TimerEntry>, greater<TimerEntry>> timers;
+    uint64_t timerSeq = 0;
+    size_t liveTasks = 0;
+    bool stopping = false;
+
+    void workerLoop() {
+        while (true) {
+            coroutine_handle<> h;
+            {
+                unique_lock<mutex> lock(mtx);
+                readyCv.wait(lock, [this] { return stopping || !ready.empty(); });
+                if (ready.empty()) return;
+                h = ready.front();
+                ready.pop_front();
+            }
+            h.resume();
+        }
+    }
+
+    void timerLoop() {
+        unique_lock<mutex> lock(mtx);
+        while (!stopping) {
+            if (timers.empty()) {
+                timerCv.wait(lock);
+                continue;
+            }
+            int64_t dueMs = timers.top().dueMs;
+            timerCv.wait_until(lock, chrono::steady_clock::time_point(chrono::milliseconds(dueMs)));
+            int64_t now = clock->nowMs();
+            while (!timers.empty() && timers.top().dueMs <= now) {
+                ready.push_back(timers.top().handle);
+                timers.pop();
+                readyCv.notify_one();
+            }
+        }
+    }
+
+    // Virtual mode: resumes everything that is runnable right now on the calling thread.
+    void runReady() {
+        while (true) {
+            coroutine_handle<> h;
+            {
+                lock_guard<mutex> lock(mtx);
+                if (ready.empty()) return;
+                h = ready.front();
+                ready.pop_front();
+            }
+            h.resume();
+        }
+    }
+
+public:
+    RideExecutor(int threadCount) {
+        this->clock = &systemClock;
+        this->virtualClock = nullptr;
+        for (int i = 0; i < threadCount; i++) {
+            workers.emplace_back(&RideExecutor::workerLoop, this);
+        }
+        timerThread = thread(&RideExecutor::timerLoop, this);
+    }
+
+    RideExecutor(VirtualClock* vc) {
+        this->clock = vc;
+        this->virtualClock = vc;
+    }
+
+    iClock* getClock() {
+        return clock;
+    }
+
+    // Takes ownership of a ride session and queues its first step.
+    void spawn(RideTask task) {
+        task.handle.promise().executor = this;
+        {
+            lock_guard<mutex> lock(mtx);
+            liveTasks++;
+        }
+        post(task.handle);
+    }
+
+    void post(coroutine_handle<> h) {
+        {
+            lock_guard<mutex> lock(mtx);
+            ready.push_back(h);
+        }
+        readyCv.notify_one();
+    }
+
+    void postAfter(chrono::milliseconds delay, coroutine_handle<> h) {
+        {
+            lock_guard<mutex> lock(mtx);
+            timers.push({clock->nowMs() + delay.count(), timerSeq++, h});
+        }
+        timerCv.notify_one();
+    }
+
+    struct SleepAwaiter {
+        RideExecutor* executor;
+        chrono::milliseconds delay;
+        bool await_ready() const noexcept { return delay.count() <= 0; }
+        void await_suspend(coroutine_handle<> h) { executor->postAfter(delay, h); }
+        void await_resume() const noexcept {}
+    };
+
+    SleepAwaiter sleepFor(chrono::milliseconds delay) {
+        return SleepAwaiter{this, delay};
+    }
+
+    void taskFinished() {
+        lock_guard<mutex> lock(mtx);
+        if (--liveTasks == 0) idleCv.notify_all();
+    }
+
+private:
+    // Virtual mode: fires every timer due up to t in order, moving the clock along with them.
+    void fireTimersUpTo(int64_t t) {
+        runReady();
+        while (true) {
+            coroutine_handle<> h;
+            {
+                lock_guard<mutex> lock(mtx);
+                if (timers.empty() || timers.top().dueMs > t) break;
+                virtualClock->advanceTo(timers.top().dueMs);
+                h = timers.top().handle;
+                timers.pop();
+            }
+            h.resume();
+            runReady();
+        }
+    }
+
+public:
+    // Virtual mode: runs everything due up to t and leaves the clock at t.
+    void runUntil(int64_t t) {
+        fireTimersUpTo(t);
+        virtualClock->advanceTo(t);
+    }
+
+    // Blocks until every spawned session has finished; virtual mode fast-forwards time.
+    void drain() {
+        if (virtualClock) {
+            fireTimersUpTo(numeric_limits<int64_t>::max());
+            return;
+        }
+        unique_lock<mutex> lock(mtx);
+        idleCv.wait(lock, [this] { return liveTasks == 0; });
+    }
+
+    ~RideExecutor() {
+        drain();
+        if (virtualClock) return;
+        {
+            lock_guard<mutex> lock(mtx);
+            stopping = true;
+        }
+        readyCv.notify_all();
+        timerCv.notify_all();
+        for (auto& w : workers) w.join();
+        timerThread.join();
+    }
+};
+
+inline void RideTask::promise_type::FinalAwaiter::await_suspend(coroutine_handle<promise_type> h) noexcept {
+    RideExecutor* executor = h.promise().executor;
+    h.destroy();
+    if (executor) executor->taskFinished();
+}
@@ -0,0 +1,174 @@
+#pragma once
+
+#include "rideExecutor.h"
+#include "rideObject.h"
+
+// --------------------- Ride identity & duplicate protection -------------------------
+
+// Snowflake-style ride ids: 41 bits of milliseconds, 10 bits of node id, 12 bits of sequence.
+class RideIdGenerator {
+private:
+    static constexpr uint64_t epochMs = 1704067200000ULL; // 2024-01-01T00:00:00Z
+    static constexpr uint64_t sequenceBits = 12;
+    static constexpr uint64_t nodeBits = 10;
+    static constexpr uint64_t sequenceMask = (1ULL << sequenceBits) - 1;
+
+    uint64_t nodeId;
+    atomic<uint64_t> state{0}; // (timestamp << sequenceBits) | sequence of the last id handed out
+
+    static uint64_t currentMs() {
+        auto now = chrono::system_clock::now().time_since_epoch();
+        return (uint64_t)chrono::duration_cast<chrono::milliseconds>(now).count() - epochMs;
+    }
+
+public:
+    RideIdGenerator(uint64_t nodeId) {
+        this->nodeId = nodeId & ((1ULL << nodeBits) - 1);
+    }
+
+    uint64_t nextId() {
+        uint64_t prev = state.load(memory_order_relaxed);
+        while (true) {
+            uint64_t now = currentMs();
+            uint64_t prevTs = prev >> sequenceBits;
+            uint64_t next;
+            if (now > prevTs) {
+                next = now << sequenceBits;
+            } else if ((prev & sequenceMask) < sequenceMask) {
+                next = prev + 1; // same millisecond (or clock stepped back): bump the sequence
+            } else {
+                next = (prevTs + 1) << sequenceBits; // sequence exhausted: borrow the next millisecond
+            }
+            if (state.compare_exchange_weak(prev, next, memory_order_relaxed)) {
+                uint64_t ts = next >> sequenceBits;
+                return (ts << (nodeBits + sequenceBits)) | (nodeId << sequenceBits) | (next & sequenceMask);
+            }
+        }
+    }
+};
+
+// Remembers which ride served each idempotency key for a short TTL, so retries get the same ride.
+class IdempotencyCache {
+private:
+    struct Entry {
+        uint64_t rideId;
+        int64_t expiresAtMs;
+    };
+
+    mutex mtx;
+    unordered_map<string, Entry> entries;
+    // Keys in insertion order; with a fixed TTL that is also expiry order.
+    deque<pair<string, int64_t>> expiryOrder;
+    chrono::milliseconds ttl;
+    iClock* clock;
+
+    // Caller holds mtx.
+    void evictExpired(int64_t now) {
+        while (!expiryOrder.empty() && expiryOrder.front().second <= now) {
+            auto it = entries.find(expiryOrder.front().first);
+            if (it != entries.end() && it->second.expiresAtMs == expiryOrder.front().second) {
+                entries.erase(it);
+            }
+            expiryOrder.pop_front();
+        }
+    }
+
+public:
+    IdempotencyCache(chrono::milliseconds ttl, iClock* clock) {
+        this->ttl = ttl;
+        this->clock = clock;
+    }
+
+    // Records key -> rideId; returns 0 if the key is new, else the ride id already issued.
+    uint64_t reserve(const string& key, uint64_t rideId) {
+        lock_guard<mutex> lock(mtx);
+        int64_t now = clock->nowMs();
+        evictExpired(now);
+        auto it = entries.find(key);
+        if (it != entries.end()) return it->second.rideId;
+        entries[key] = {rideId, now + ttl.count()};
+        expiryOrder.push_back({key, now + ttl.count()});
+        return 0;
+    }
+
+    // Forgets key while it still maps to rideId, e.g. the ride ended unserved.
+    void release(const string& key, uint64_t rideId) {
+        lock_guard<mutex> lock(mtx);
+        auto it = entries.find(key);
+        if (it != entries.end() && it->second.rideId == rideId) entries.erase(it);
+    }
+};
+
+// Per-user index of the ride currently in flight, for O(1) "already has a live ride" checks.
+// A ride admitted here belongs to the index until the step that ends it calls retire().
+class ActiveRideIndex {
+private:
+    mutex mtx;
+    unordered_map<string, RideObject*> rides;
+    function<void(RideObject*)> onRetire; // null: retired rides are deleted
+
+    void dispose(RideObject* ride) {
+        if (onRetire) {
+            onRetire(ride);
+        } else {
+            delete ride;
+        }
+    }
+
+public:
+    ActiveRideIndex(function<void(RideObject*)> onRetire = nullptr) : onRetire(move(onRetire)) {}
+
+    // Registers the ride for its user; fails if the user already has a live ride.
+    bool tryAcquire(const string& userName, RideObject* ride) {
+        lock_guard<mutex> lock(mtx);
+        return rides.emplace(userName, ride).second;
+    }
+
+    // Flags the user's live ride for cancellation and wakes its session, under the lock so the ride stays live.
+    bool requestCancel(const string& userName) {
+        lock_guard<mutex> lock(mtx);
+        auto it = rides.find(userName);
+        if (it == rides.end()) return false;
+        it->second->cancelRequested = true;
+        it->second->pickupSignal.fire(PickupSignal::Cancelled);
+        return true;
+    }
+
+    // The rider app reports the rider on board; ignored unless rideId is still the user's live ride.
+    bool confirmBoarding(const string& userName, uint64_t rideId) {
+        lock_guard<mutex> lock(mtx);
+        auto it = rides.find(userName);
+        if (it == rides.end() || it->second->rideId != rideId) return false;
+        return it->second->pickupSignal.fire(PickupSignal::Boarded);
+    }
+
+    // Ends the ride's time in the index. The caller must not touch ride afterwards.
+    void retire(RideObject* ride) {
+        {
+            lock_guard<mutex> lock(mtx);
+            auto it = rides.find(ride->name);
+            if (it != rides.end() && it->second == ride) rides.erase(it);
+        }
+        dispose(ride);
+    }
+
+    size_t size() {
+        lock_guard<mutex> lock(mtx);
+        return rides.size();
+    }
+
+    // Holds off registrations and releases, e.g. while a snapshot is taken.
+    unique_lock<mutex> lockState() {
+        return unique_lock<mutex>(mtx);
+    }
+
+    // Caller holds lockState().
+    const unordered_map<string, RideObject*>& ridesLocked() const {
+        return rides;
+    }
+
+    // Rides still in flight at shutdown go the same way as retired ones.
+    ~ActiveRideIndex() {
+        for (auto& kv : rides) dispose(kv.second);
+    }
+};
@@ -0,0 +1,323 @@
+#pragma once
+
+#include "rideCommon.h"
+
+// ------------------------ Asynchronous logger ------------------------
+// LOG_* copies its arguments into a per-thread ring buffer; a background writer formats and
+// writes them in batches. Levels below RIDE_LOG_MIN_LEVEL are compiled out.
+
+enum LogLevel { LOG_LEVEL_DEBUG = 0, LOG_LEVEL_INFO = 1, LOG_LEVEL_WARN = 2, LOG_LEVEL_ERROR = 3 };
+
+#ifndef RIDE_LOG_MIN_LEVEL
+#define RIDE_LOG_MIN_LEVEL 1
+#endif
+
+// Single-producer / single-consumer byte ring owned by one logging thread. Records are
+// [uint32 size][payload] and never straddle the end; a zero size means "skip to start".
+class LogBuffer {
+public:
+    static constexpr size_t capacity = 1 << 14;
+
+    alignas(64) atomic<uint64_t> writePos{0};
+    alignas(64) atomic<uint64_t> readPos{0};
+    atomic<bool> retired{false}; // owning thread exited; free once drained
+    uint8_t data[capacity];
+
+    // Producer side: room for n contiguous bytes after the size header, or nullptr if full.
+    uint8_t* reserve(size_t n, uint64_t& recordStart) {
+        size_t total = (4 + n + 3) & ~(size_t)3;
+        uint64_t w = writePos.load(memory_order_relaxed);
+        uint64_t r = readPos.load(memory_order_acquire);
+        size_t off = (size_t)(w % capacity);
+        size_t contiguous = capacity - off;
+        if (contiguous < total) {
+            if (w + contiguous + total - r > capacity) return nullptr;
+            uint32_t skip = 0;
+            memcpy(data + off, &skip, 4);
+            w += contiguous;
+            off = 0;
+        } else if (w + total - r > capacity) {
+            return nullptr;
+        }
+        uint32_t size = (uint32_t)total;
+        memcpy(data + off, &size, 4);
+        recordStart = w;
+        return data + off + 4;
+    }
+
+    void commit(uint64_t recordStart) {
+        uint32_t size;
+        memcpy(&size, data + recordStart % capacity, 4);
+        writePos.store(recordStart + size, memory_order_release);
+    }
+};
+
+class AsyncLogger {
+private:
+    // Argument type tags in the binary record
+    enum : uint8_t { ArgInt = 'i', ArgUInt = 'u', ArgDouble = 'd', ArgString = 's', ArgChar = 'c', ArgBool = 'b' };
+
+    static constexpr size_t maxThreadBuffers = 64;
+
+    struct ThreadSlot {
+        LogBuffer* buffer = nullptr;
+        bool shared = false;
+        ~ThreadSlot() {
+            if (buffer && !shared) buffer->retired = true;
+        }
+    };
+
+    mutex registryMtx;
+    vector<LogBuffer*> buffers;
+    LogBuffer* sharedBuffer;
+    mutex sharedMtx; // producers on sharedBuffer
+    atomic<int> minLevel{RIDE_LOG_MIN_LEVEL};
+    atomic<uint64_t> dropped{0};
+    atomic<bool> stopping{false};
+    mutex drainMtx; // the writer thread and flush() may both drain
+    mutex fileMtx;
+    FILE* out = stderr;
+    bool ownsFile = false;
+    thread writer;
+
+    ThreadSlot& threadSlot() {
+        static thread_local ThreadSlot slot;
+        if (!slot.buffer) {
+            lock_guard<mutex> lock(registryMtx);
+            if (buffers.size() > maxThreadBuffers) {
+                slot.buffer = sharedBuffer;
+                slot.shared = true;
+            } else {
+                slot.buffer = new LogBuffer();
+                buffers.push_back(slot.buffer);
+            }
+        }
+        return slot;
+    }
+
+    // --- encoding (producer side) ---
+    template <typename T>
+    static size_t encodedSize(const T& v) {
+        if constexpr (is_same_v<decay_t<T>, bool> || is_same_v<decay_t<T>, char>) {
+            return 2;
+        } else if constexpr (is_integral_v<decay_t<T>> || is_enum_v<decay_t<T>> || is_floating_point_v<decay_t<T>>) {
+            return 9;
+        } else {
+            return 5 + string_view(v).size();
+        }
+    }
+
+    template <typename T>
+    static void encode(uint8_t*& p, const T& v) {
+        using D = decay_t<T>;
+        if constexpr (is_same_v<D, bool>) {
+            *p++ = ArgBool;
+            *p++ = v ? 1 : 0;
+        } else if constexpr (is_same_v<D, char>) {
+            *p++ = ArgChar;
+            *p++ = (uint8_t)v;
+        } else if constexpr (is_floating_point_v<D>) {
+            double d = (double)v;
+            *p++ = ArgDouble;
+            memcpy(p, &d, 8);
+            p += 8;
+        } else if constexpr ((is_integral_v<D> && is_unsigned_v<D>)) {
+            uint64_t u = (uint64_t)v;
+            *p++ = ArgUInt;
+            memcpy(p, &u, 8);
+            p += 8;
+        } else if constexpr (is_integral_v<D> || is_enum_v<D>) {
+            int64_t i = (int64_t)v;
+            *p++ = ArgInt;
+            memcpy(p, &i, 8);
+            p += 8;
+        } else {
+            string_view s(v);
+            uint32_t len = (uint32_t)s.size();
+            *p++ = ArgString;
+            memcpy(p, &len, 4);
+            memcpy(p + 4, s.data(), len);
+            p += 4 + len;
+        }
+    }
+
+    // --- decoding + formatting (writer side) ---
+    static void appendArg(string& out, const uint8_t*& p) {
+        uint8_t tag = *p++;
+        switch (tag) {
+            case ArgBool: out += (*p++ ? "true" : "false"); break;
+            case ArgChar: out += (char)*p++; break;
+            case ArgDouble: { double d; memcpy(&d, p, 8); p += 8; char buf[32]; snprintf(buf, sizeof(buf), "%g", d); out += buf; break; }
+            case ArgUInt: { uint64_t u; memcpy(&u, p, 8); p += 8; out += to_string(u); break; }
+            case ArgInt: { int64_t i; memcpy(&i, p, 8); p += 8; out += to_string(i); break; }
+            default: { uint32_t len; memcpy(&len, p, 4); out.append((const char*)p + 4, len); p += 4 + len; break; }
+        }
+    }
+
+    static void formatRecord(string& out, const uint8_t* p) {
+        static const char* levelNames[] = {"DEBUG", "INFO", "WARN", "ERROR"};
+        int64_t ns;
+        memcpy(&ns, p, 8);
+        uint8_t level = p[8];
+        const char* fmt;
+        memcpy(&fmt, p + 9, sizeof(fmt));
+        uint8_t argc = p[9 + sizeof(fmt)];
+        p += 10 + sizeof(fmt);
+
+        char stamp[48];
+        time_t secs = (time_t)(ns / 1000000000);
+        struct tm tmv;
+#ifdef _WIN32
+        localtime_s(&tmv, &secs);
+#else
+        localtime_r(&secs, &tmv);
+#endif
+        size_t len = strftime(stamp, sizeof(stamp), "%H:%M:%S", &tmv);
+        snprintf(stamp + len, sizeof(stamp) - len, ".%06lld", (long long)((ns / 1000) % 1000000));
+        out += stamp;
+        out += ' ';
+        out += levelNames[level & 3];
+        out += ' ';
+        for (const char* f = fmt; *f; f++) {
+            if (f[0] == '{' && f[1] == '}' && argc > 0) {
+                appendArg(out, p);
+                argc--;
+                f++;
+            } else {
+                out += *f;
+            }
+        }
+        out += '\n';
+    }
+
+    // Drains every buffer once; returns whether anything was written.
+    bool drainOnce() {
+        lock_guard<mutex> drainLock(drainMtx);
+        string batch;
+        vector<LogBuffer*> snapshot;
+        {
+            lock_guard<mutex> lock(registryMtx);
+            snapshot = buffers;
+        }
+        for (LogBuffer* b : snapshot) {
+            uint64_t r = b->readPos.load(memory_order_relaxed);
+            uint64_t w = b->writePos.load(memory_order_acquire);
+            while (r < w) {
+                size_t off = (size_t)(r % LogBuffer::capacity);
+                uint32_t size;
+                memcpy(&size, b->data + off, 4);
+                if (size == 0) {
+                    r += LogBuffer::capacity - off;
+                    continue;
+                }
+                formatRecord(batch, b->data + off + 4);
+                r += size;
+            }
+            b->readPos.store(r, memory_order_release);
+        }
+        {
+            // Free buffers of threads that have exited once they are empty
+            lock_guard<mutex> lock(registryMtx);
+            for (size_t i = 0; i < buffers.size();) {
+                LogBuffer* b = buffers[i];
+                if (b->retired && b->readPos.load() == b->writePos.load()) {
+                    delete b;
+                    buffers[i] = buffers.back();
+                    buffers.pop_back();
+                } else {
+                    i++;
+                }
+            }
+        }
+        if (batch.empty()) return false;
+        lock_guard<mutex> lock(fileMtx);
+        fwrite(batch.data(), 1, batch.size(), out);
+        fflush(out);
+        return true;
+    }
+
+    AsyncLogger() {
+        sharedBuffer = new LogBuffer();
+        buffers.push_back(sharedBuffer);
+        writer = thread([this] {
+            while (!stopping) {
+                if (!drainOnce()) this_thread::sleep_for(chrono::milliseconds(2));
+            }
+        });
+    }
+
+public:
+    static AsyncLogger& instance() {
+        static AsyncLogger logger;
+        return logger;
+    }
+
+    // Sends log output to a file (appending) instead of stderr.
+    bool open(const string& path) {
+        FILE* f = fopen(path.c_str(), "a");
+        if (!f) return false;
+        lock_guard<mutex> lock(fileMtx);
+        if (ownsFile) fclose(out);
+        out = f;
+        ownsFile = true;
+        return true;
+    }
+
+    void setMinLevel(LogLevel level) {
+        minLevel = level;
+    }
+
+    uint64_t droppedRecords() const {
+        return dropped.load();
+    }
+
+    // fmt must outlive the process (a string literal): only its address is recorded.
+    template <size_t N, typename... Args>
+    void log(LogLevel level, const char (&fmt)[N], const Args&... args) {
+        if (level < minLevel.load(memory_order_relaxed)) return;
+        size_t payload = 8 + 1 + sizeof(const char*) + 1 + (size_t(0) + ... + encodedSize(args));
+        ThreadSlot& slot = threadSlot();
+        LogBuffer* b = slot.buffer;
+        unique_lock<mutex> sharedLock(sharedMtx, defer_lock);
+        if (slot.shared) sharedLock.lock();
+        uint64_t start;
+        uint8_t* p = b->reserve(payload, start);
+        if (!p) {
+            dropped.fetch_add(1, memory_order_relaxed); // writer is behind; never block the caller
+            return;
+        }
+        int64_t ns = chrono::duration_cast<chrono::nanoseconds>(chrono::system_clock::now().time_since_epoch()).count();
+        const char* fmtPtr = fmt;
+        memcpy(p, &ns, 8);
+        p[8] = (uint8_t)level;
+        memcpy(p + 9, &fmtPtr, sizeof(fmtPtr));
+        p[9 + sizeof(fmtPtr)] = (uint8_t)sizeof...(args);
+        p += 10 + sizeof(fmtPtr);
+        (encode(p, args), ...);
+        b->commit(start);
+    }
+
+    // Blocks until everything logged so far has been written.
+    void flush() {
+        while (drainOnce()) {
+        }
+    }
+
+    ~AsyncLogger() {
+        stopping = true;
+        writer.join();
+        flush();
+        if (dropped > 0) fprintf(out, "[logger] %llu records dropped\n", (unsigned long long)dropped.load());
+        if (ownsFile) fclose(out);
+        for (LogBuffer* b : buffers) delete b;
+    }
+};
+
+#define RIDE_LOG(level, ...) \
+    do { \
+        if constexpr ((level) >= RIDE_LOG_MIN_LEVEL) AsyncLogger::instance().log((level), __VA_ARGS__); \
+    } while (0)
+#define LOG_DEBUG(...) RIDE_LOG(LOG_LEVEL_DEBUG, __VA_ARGS__)
+#define LOG_INFO(...) RIDE_LOG(LOG_LEVEL_INFO, __VA_ARGS__)
+#define LOG_WARN(...) RIDE_LOG(LOG_LEVEL_WARN, __VA_ARGS__)
+#define LOG_ERROR(...) RIDE_LOG(LOG_LEVEL_ERROR, __VA_ARGS__)
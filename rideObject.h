@@ -0,0 +1,145 @@
+#pragma once
+
+#include "rideExecutor.h"
+
+// --------------------- Ride Object -------------------------
+
+// Where a session waits for the driver's arrival and then the rider; the first event decides.
+// The resumed session may free the ride, so fire() touches nothing after unlocking.
+class PickupSignal {
+public:
+    enum Outcome { Waiting, Arrived, Boarded, Cancelled, NoShow };
+
+private:
+    mutex mtx;
+    Outcome outcome = Waiting;
+    coroutine_handle<> waiter;
+    RideExecutor* executor = nullptr;
+
+public:
+    bool fire(Outcome why) {
+        coroutine_handle<> h;
+        RideExecutor* ex;
+        {
+            lock_guard<mutex> lock(mtx);
+            if (outcome != Waiting) return false;
+            outcome = why;
+            h = waiter;
+            ex = executor;
+        }
+        if (h) ex->post(h);
+        return true;
+    }
+
+    struct Awaiter {
+        PickupSignal* signal;
+        RideExecutor* executor;
+
+        bool await_ready() {
+            lock_guard<mutex> lock(signal->mtx);
+            return signal->outcome != Waiting;
+        }
+        bool await_suspend(coroutine_handle<> h) {
+            lock_guard<mutex> lock(signal->mtx);
+            if (signal->outcome != Waiting) return false; // decided meanwhile: carry on
+            signal->waiter = h;
+            signal->executor = executor;
+            return true;
+        }
+        Outcome await_resume() {
+            lock_guard<mutex> lock(signal->mtx);
+            return signal->outcome;
+        }
+    };
+
+    Awaiter wait(RideExecutor* ex) {
+        return Awaiter{this, ex};
+    }
+
+    // After the driver's arrival, waits again for the rider; a cancellation stays decided.
+    void rearm() {
+        lock_guard<mutex> lock(mtx);
+        if (outcome == Arrived) outcome = Waiting;
+        waiter = nullptr;
+        executor = nullptr;
+    }
+};
+class RideObject {
+public:
+    string start;
+    string dest;
+    string name; // User's name
+    string rideStatus;
+    string rideType;
+    string vehicle;
+    string vehicleType;
+    string driverName;
+    int fare; 
+    uint64_t rideId;        // assigned at intake by RideIdGenerator
+    string idempotencyKey;  // client-supplied retry key; derived from the request when empty
+    atomic<bool> cancelRequested;
+    atomic<bool> freeCancellation;  // cleared when the free-cancellation window closes
+    vector<string> excludedDrivers; // drivers who declined or let the offer lapse
+    string pricing;    // fare table the fare was computed with (normal | peak)
+    string pickupZone; // airport zone the ride starts in, "" if none
+    string destZone;
+    // Milestones on the executor's clock, 0 until reached
+    atomic<int64_t> requestedAtMs;
+    atomic<int64_t> matchedAtMs;  // the driver who ends up serving the ride was allocated
+    atomic<int64_t> acceptedAtMs; // first accepted; the free-cancellation window runs from here
+    atomic<int64_t> pickupAtMs;
+    atomic<int64_t> completedAtMs;
+    atomic<int64_t> cancelledAtMs;
+    PickupSignal pickupSignal;
+
+    RideObject(string start = "", string dest = "", string name = "", string vehicle = "", string vehicleType = "") {
+        this->start = start;
+        this->dest = dest;
+        this->name = name;
+        this->rideStatus = "pending";
+        this->rideType = "normal";
+        this->vehicle = vehicle;
+        this->vehicleType = vehicleType;
+        this->driverName = "";
+        this->fare = 0;
+        this->rideId = 0;
+        this->idempotencyKey = "";
+        this->cancelRequested = false;
+        this->freeCancellation = true;
+        this->requestedAtMs = 0;
+        this->matchedAtMs = 0;
+        this->acceptedAtMs = 0;
+        this->pickupAtMs = 0;
+        this->completedAtMs = 0;
+        this->cancelledAtMs = 0;
+    }
+
+    // Status, driver and fare are written through these; a checkpoint copies under lockState().
+    void setStatus(const string& status) {
+        lock_guard<mutex> lock(stateMtx);
+        rideStatus = status;
+    }
+
+    void assignDriver(const string& driver, const string& status) {
+        lock_guard<mutex> lock(stateMtx);
+        driverName = driver;
+        rideStatus = status;
+    }
+
+    void setFare(int amount) {
+        lock_guard<mutex> lock(stateMtx);
+        fare = amount;
+    }
+
+    void excludeDriver(const string& driver) {
+        lock_guard<mutex> lock(stateMtx);
+        excludedDrivers.push_back(driver);
+    }
+
+    unique_lock<mutex> lockState() const {
+        return unique_lock<mutex>(stateMtx);
+    }
+
+private:
+    mutable mutex stateMtx;
+};
@@ -0,0 +1,342 @@
+#pragma once
+
+#include "rideLogger.h"
+#include "rideExecutor.h"
+#include "geoPoint.h"
+#include "fleetTable.h"
+#include "geoLocation.h"
+#include "rideObject.h"
+#include "rideIdentity.h"
+#include "rideTimeouts.h"
+#include "geofence.h"
+#include "bookingFactories.h"
+#include "priceCalculator.h"
+#include "bookingSubject.h"
+#include "driverAllocation.h"
+#include "notifications.h"
+#include "allocationOrchestrator.h"
+#include "rideSession.h"
+#include "allocationWorkers.h"
+#include "admission.h"
+
+// --------------------- RideRequestManager (New Class - Observer for BookingManager) -------------------------
+// This class will listen for new ride bookings and orchestrate driver allocation and initial notifications.
+class RideRequestManager : public iBookingObserver {
+private:
+    NotificationEngine* notificationEngine;
+    GeoLocationManager* geoManager;
+    PaymentGateway* paymentGateway;
+    IDriverAllocationOrchestrator* driverAllocationOrchestrator;
+    RideExecutor* rideExecutor;
+    ActiveRideIndex* activeRides;
+    IdempotencyCache* idempotencyCache;
+    DriverRatingStore* ratingStore;
+    RideTimeoutManager* timeouts;
+    AllocationWorkerPool* allocationWorkers; // null: allocate on the booking thread
+
+    enum OfferAnswer { Accepted, Declined, Lapsed, Withdrawn };
+
+    struct OpenOffer {
+        RideObject* ride;
+        string driverName;
+    };
+
+    mutex offersMtx;
+    unordered_map<uint64_t, OpenOffer> openOffers; // rideId -> offer waiting for the driver's answer
+
+    static constexpr size_t maxOffers = 3;
+
+    // Stand-in for the driver app: the driver looks at the offer for a while and takes it.
+    static RideTask simulateDriverAnswer(RideExecutor* executor, RideRequestManager* manager, uint64_t rideId,
+                                         string driverName, chrono::milliseconds delay) {
+        co_await executor->sleepFor(delay);
+        manager->answerOffer(rideId, driverName, true);
+    }
+
+    // Allocation runs on the pool when there is one; rides from the same pickup cell go to the same worker.
+    void dispatch(RideObject* r) {
+        if (!allocationWorkers) {
+            offerRide(r);
+            return;
+        }
+        GeoPoint pickup;
+        uint64_t localityKey = geoManager->resolve(r->start, pickup) ? FleetTable::cellOf(pickup) : hash<string>{}(r->start);
+        allocationWorkers->submit(localityKey, [this, r] { offerRide(r); });
+    }
+
+    // Allocates a driver and offers the ride; a rejection or lapse moves it to the next candidate.
+    void offerRide(RideObject* r) {
+        // Orchestrate driver allocation
+        driverAllocationOrchestrator->orchestrate(r);
+
+        if (r->rideStatus != "confirmed") {
+            failAllocation(r);
+            return;
+        }
+
+        LOG_INFO("[RideRequestManager] Driver {} successfully allocated. Waiting for them to accept.", r->driverName);
+        r->matchedAtMs = rideExecutor->getClock()->nowMs();
+        uint64_t rideId = r->rideId;
+        string driverName = r->driverName;
+        {
+            lock_guard<mutex> lock(offersMtx);
+            openOffers[rideId] = {r, driverName};
+        }
+        timeouts->arm(r, RideTimeoutManager::AcceptDeadline, timeouts->acceptTimeout, [this, rideId, driverName] {
+            settleOffer(rideId, driverName, Lapsed);
+        });
+        if (!AppSimulation::rolls(apps.lapsedOfferPercent, rideId, driverName)) {
+            rideExecutor->spawn(simulateDriverAnswer(rideExecutor, this, rideId, driverName, apps.driverAnswerDelay));
+        }
+    }
+
+    // The driver's answer and the accept deadline race for the offer; the later one does nothing.
+    bool settleOffer(uint64_t rideId, const string& driverName, OfferAnswer answer) {
+        RideObject* r;
+        {
+            lock_guard<mutex> lock(offersMtx);
+            auto it = openOffers.find(rideId);
+            if (it == openOffers.end() || it->second.driverName != driverName) return false;
+            r = it->second.ride;
+            openOffers.erase(it);
+        }
+        if (answer != Lapsed) timeouts->disarm(r, RideTimeoutManager::AcceptDeadline);
+
+        if (r->cancelRequested) {
+            // The rider gave up while the offer was out
+            RideManager* rideManager = new RideManager(r, geoManager, notificationEngine, paymentGateway, rideExecutor,
+                                                       activeRides, idempotencyCache, ratingStore, timeouts, &apps);
+            rideManager->endCancelled();
+        } else if (answer == Accepted) {
+            notificationEngine->notify("rideAccepted", r); // This will change status to "driver_on_the_way"
+            startRideSession(r);
+        } else {
+            reassign(r, answer == Declined ? "rejected the ride" : "did not accept in time");
+        }
+        return true;
+    }
+
+    // Withdraws the offer from the current driver, who goes back to the idle pool.
+    void reassign(RideObject* r, string reason) {
+        LOG_INFO("[RideRequestManager] Driver {} {}. Offering the ride to the next driver.", r->driverName, reason);
+        ratingStore->releaseDriver(r->driverName);
+        notificationEngine->notifyDriver("The ride for " + r->name + " is no longer offered to you.", r->driverName);
+        r->excludeDriver(r->driverName);
+        r->assignDriver("", "pending");
+        r->matchedAtMs = 0;
+        if (r->excludedDrivers.size() >= maxOffers) {
+            failAllocation(r);
+            return;
+        }
+        dispatch(r);
+    }
+
+    void startRideSession(RideObject* r) {
+        // A ride restored after its first acceptance keeps what was left of its window
+        int64_t now = rideExecutor->getClock()->nowMs();
+        if (r->acceptedAtMs == 0) r->acceptedAtMs = now;
+        if (r->freeCancellation) {
+            auto left = max(timeouts->freeCancellationWindow - chrono::milliseconds(now - r->acceptedAtMs), chrono::milliseconds(0));
+            timeouts->arm(r, RideTimeoutManager::CancellationWindow, left, [r] {
+                r->freeCancellation = false;
+            });
+        }
+        // Hand over to RideManager; the live session runs on the ride executor
+        RideManager* rideManager = new RideManager(r, geoManager, notificationEngine, paymentGateway, rideExecutor,
+                                                   activeRides, idempotencyCache, ratingStore, timeouts, &apps);
+        if (rideManager->startRide()) return;
+        delete rideManager;
+        timeouts->disarmAll(r);
+        activeRides->retire(r);
+    }
+
+    void failAllocation(RideObject* r) {
+        LOG_WARN("[RideRequestManager] Driver allocation failed or ride rejected for {}.", r->name);
+        timeouts->disarmAll(r);
+        idempotencyCache->release(r->idempotencyKey, r->rideId); // so "Please try again" really does
+        notificationEngine->notifyUser("Unfortunately, we could not find a driver for your ride at this time. Please try again.", r->name);
+        activeRides->retire(r);
+    }
+
+public:
+    AppSimulation apps;
+
+    RideRequestManager(NotificationEngine* ne, GeoLocationManager* gm, PaymentGateway* pg, IDriverAllocationOrchestrator* dao,
+                       RideExecutor* ex, ActiveRideIndex* ar, IdempotencyCache* ic, DriverRatingStore* rs,
+                       RideTimeoutManager* tm, AllocationWorkerPool* workers)
+        : notificationEngine(ne), geoManager(gm), paymentGateway(pg), driverAllocationOrchestrator(dao),
+          rideExecutor(ex), activeRides(ar), idempotencyCache(ic), ratingStore(rs), timeouts(tm), allocationWorkers(workers) {}
+
+    void notifyBookingDetails(RideObject* r) override {
+        LOG_INFO("[RideRequestManager] Received new ride request for {}. Initiating driver allocation.", r->name);
+        dispatch(r);
+    }
+
+    // A finished trip is only charged; anything short of that is matched again from scratch.
+    void notifyRestoredRide(RideObject* r) override {
+        if (r->rideStatus == "completed") {
+            RideManager* rideManager = new RideManager(r, geoManager, notificationEngine, paymentGateway, rideExecutor,
+                                                       activeRides, idempotencyCache, ratingStore, timeouts, &apps);
+            if (rideManager->resumePayment()) return;
+            delete rideManager;
+            activeRides->retire(r);
+            return;
+        }
+        LOG_INFO("[RideRequestManager] Restored ride {} for {}. Matching it again.", r->rideId, r->name);
+        r->assignDriver("", "pending");
+        r->matchedAtMs = 0;
+        dispatch(r);
+    }
+
+    // A driver's answer to an offer; false if it came too late (the offer lapsed or was withdrawn).
+    bool answerOffer(uint64_t rideId, const string& driverName, bool accepted) {
+        return settleOffer(rideId, driverName, accepted ? Accepted : Declined);
+    }
+
+    // Rider-initiated cancellation; an open offer is withdrawn at once, a live session wakes up to it.
+    bool cancelRide(const string& userName) {
+        if (!activeRides->requestCancel(userName)) return false;
+        uint64_t rideId = 0;
+        string driverName;
+        {
+            lock_guard<mutex> lock(offersMtx);
+            for (auto& [id, offer] : openOffers) {
+                if (offer.ride->name == userName) {
+                    rideId = id;
+                    driverName = offer.driverName;
+                    break;
+                }
+            }
+        }
+        if (rideId) settleOffer(rideId, driverName, Withdrawn);
+        return true;
+    }
+};
+
+
+// --------------------- Booking Manager -------------------------
+class BookingManager {
+private:
+    IRideTypeFactorySelector* rideTypeFactorySelector;
+    IVehicleFactorySelector* vehicleFactorySelector;
+    IPriceCalculator* priceCalculator;
+    iBookingSubject* bookingSubject; // Now owns the subject to notify observers
+    RideIdGenerator* rideIdGenerator;
+    IdempotencyCache* idempotencyCache;
+    ActiveRideIndex* activeRides;
+    AdmissionController* admission; // null: no rate limits or load shedding
+    GeofenceEngine* geofence;       // null: locations are not validated
+
+public:
+    BookingManager(IRideTypeFactorySelector* rtfs, IVehicleFactorySelector* vfs,
+                   IPriceCalculator* pc, iBookingSubject* bs,
+                   RideIdGenerator* ids, IdempotencyCache* ic, ActiveRideIndex* ar, AdmissionController* ac,
+                   GeofenceEngine* ge)
+        : rideTypeFactorySelector(rtfs), vehicleFactorySelector(vfs),
+          priceCalculator(pc), bookingSubject(bs),
+          rideIdGenerator(ids), idempotencyCache(ic), activeRides(ar), admission(ac), geofence(ge) {}
+
+    void createBooking() {
+        RideObject* ride = new RideObject(); // BookingManager creates the RideObject
+
+        bookRide* br = new bookRide(ride); // Handles user input for booking details
+        br->book(ride);
+        delete br; // Clean up immediately after use
+
+        submitBooking(ride);
+    }
+
+    // Intake for a ride request; takes ownership of ride. Returns the serving ride's id, or 0 if rejected.
+    uint64_t submitBooking(RideObject* ride) {
+        // Turn floods away before they cost an id, a cache entry or any allocation work
+        if (admission) {
+            AdmissionController::Decision decision = admission->admitBooking(ride->name, ride->start);
+            if (decision != AdmissionController::Admitted) {
+                LOG_WARN("[BookingManager] Booking from {} rejected: {}.", ride->name, AdmissionController::describe(decision));
+                delete ride;
+                return 0;
+            }
+        }
+
+        string reason;
+        if (geofence && !geofence->tagRide(ride, reason)) {
+            cout << "[BookingManager] Cannot serve " << ride->name << ": " << reason << ". Booking rejected.\n";
+            delete ride;
+            return 0;
+        }
+
+        string key = ride->idempotencyKey.empty()
+            ? ride->name + "|" + ride->start + "|" + ride->dest + "|" + ride->rideType + "|" + ride->vehicle
+            : ride->idempotencyKey;
+
+        uint64_t rideId = rideIdGenerator->nextId();
+        uint64_t existing = idempotencyCache->reserve(key, rideId);
+        if (existing != 0) {
+            cout << "[BookingManager] Duplicate submission from " << ride->name << ", already served by ride " << existing << ".\n";
+            delete ride;
+            return existing;
+        }
+
+        ride->rideId = rideId;
+        ride->idempotencyKey = key;
+
+        // The ride is filled in before it is registered; from then on a checkpoint may copy it
+        // Step 2: Choose ride type using injected selector
+        vehicleTypeFactory* rideTypeFactory = rideTypeFactorySelector->selectRideTypeFactory(ride->rideType);
+        rideTypeFactory->createBooking(ride);
+        delete rideTypeFactory;
+
+        // Step 3: Choose vehicle type using injected selector
+        iVehicleTypeFactory* vehicleFactory = vehicleFactorySelector->selectVehicleFactory(ride->vehicle);
+        vehicleFactory->bookVehicle(ride);
+        delete vehicleFactory;
+
+        // Calculate price using injected calculator
+        int fare = priceCalculator->calculateFare(ride);
+        ride->fare = fare; // Store fare in RideObject
+
+        if (!activeRides->tryAcquire(ride->name, ride)) {
+            cout << "[BookingManager] " << ride->name << " already has a live ride. Booking rejected.\n";
+            idempotencyCache->release(key, rideId);
+            delete ride;
+            return 0;
+        }
+
+        // Final Summary
+        cout << "\nFinal Booking Summary:\n";
+        cout << "Name: " << ride->name
+             << "\nStart: " << ride->start
+             << "\nDestination: " << ride->dest
+             << "\nVehicle: " << ride->vehicle
+             << "\nVehicle Type: " << ride->vehicleType
+             << "\nRide Type: " << ride->rideType
+             << "\nRide ID: " << ride->rideId << "\n";
+        cout << "Price of fare is: " << fare << endl;
+
+        // Notify observers (RideRequestManager) that a new booking has been created
+        bookingSubject->notify(ride);
+        return rideId;
+    }
+
+    // Re-admits a restored ride (taking ownership): completed trips go to payment, the rest
+    // back to matching; settled ones end here.
+    void resumeRide(RideObject* ride) {
+        if (ride->rideStatus == "paid" || ride->rideStatus == "payment_held" || ride->rideStatus == "cancelled") {
+            cout << "[BookingManager] Restored ride " << ride->rideId << " had already ended (" << ride->rideStatus << "). Not resumed.\n";
+            delete ride;
+            return;
+        }
+        if (!activeRides->tryAcquire(ride->name, ride)) {
+            cout << "[BookingManager] " << ride->name << " already has a live ride. Restored ride " << ride->rideId << " dropped.\n";
+            delete ride;
+            return;
+        }
+        idempotencyCache->reserve(ride->idempotencyKey, ride->rideId);
+        cout << "[BookingManager] Resuming ride " << ride->rideId << " for " << ride->name << ".\n";
+        bookingSubject->notifyRestored(ride);
+    }
+
+    ~BookingManager() {
+        delete bookingSubject;
+    }
+};
@@ -0,0 +1,287 @@
+#pragma once
+
+#include "rideLogger.h"
+#include "rideExecutor.h"
+#include "geoLocation.h"
+#include "rideObject.h"
+#include "rideIdentity.h"
+#include "rideTimeouts.h"
+#include "driverAllocation.h"
+#include "notifications.h"
+#include "riskScoring.h"
+#include "earningsLedger.h"
+
+// ------------------------ Payment Gateway Class ------------------------
+class PaymentGateway {
+    RiskScorer* risk;         // null: every fare is charged as is
+    EarningsLedger* earnings; // null: paid rides are not attributed
+
+public:
+    PaymentGateway(RiskScorer* risk, EarningsLedger* earnings) {
+        this->risk = risk;
+        this->earnings = earnings;
+    }
+
+    // Inline risk check; returns false when the payment is held for review instead of charged.
+    bool screenPayment(RideObject* ride) {
+        if (!risk) return true;
+        RiskScorer::Assessment a = risk->score(ride);
+        if (a.decision == RiskScorer::Hold) {
+            cout << "Payment for Ride ID " << ride->rideId << " is on hold for review.\n";
+            LOG_WARN("[PaymentGateway] Holding payment for ride {} (risk {}): {}", ride->rideId, a.score, a.reasons);
+            ride->setStatus("payment_held");
+            return false;
+        }
+        if (a.decision == RiskScorer::Review) {
+            LOG_WARN("[PaymentGateway] Ride {} flagged for review (risk {}): {}", ride->rideId, a.score, a.reasons);
+        }
+        return true;
+    }
+
+    void beginPayment(RideObject* ride, int fare) {
+        cout << "\n--- Redirecting to Payment Gateway ---\n";
+        cout << "User: " << ride->name << endl;
+        cout << "Ride from: " << ride->start << " to: " << ride->dest << endl;
+        cout << "Amount Due: " << fare << " INR" << endl;
+        cout << "Payment processing initiated for Ride ID: " << ride->rideId << endl;
+    }
+
+    bool completePayment(RideObject* ride) {
+        if (ride->rideStatus == "cancelled") {
+            cout << "Cancellation fee of " << ride->fare << " INR charged.\n"; // the ride stays cancelled
+        } else {
+            cout << "Payment successful! Thank you for riding with us.\n";
+            ride->setStatus("paid"); // Update ride status to indicate payment
+        }
+        if (earnings) earnings->credit(ride);
+        return true;
+    }
+
+    // Awaitable payment; the session resumes with the gateway's result.
+    struct PaymentAwaiter {
+        PaymentGateway* gateway;
+        RideExecutor* executor;
+        RideObject* ride;
+        int fare;
+        bool cleared;
+
+        bool await_ready() const noexcept { return !cleared; } // held payments never reach the gateway
+        void await_suspend(coroutine_handle<> h) {
+            gateway->beginPayment(ride, fare);
+            // Simulate external payment processing
+            executor->postAfter(chrono::seconds(3), h);
+        }
+        bool await_resume() { return cleared && gateway->completePayment(ride); }
+    };
+
+    PaymentAwaiter processPayment(RideExecutor* executor, RideObject* ride, int fare) {
+        return PaymentAwaiter{this, executor, ride, fare, screenPayment(ride)};
+    }
+
+    // A fixed fee on a cancelled ride; there is no trip to score.
+    PaymentAwaiter chargeCancellationFee(RideExecutor* executor, RideObject* ride) {
+        return PaymentAwaiter{this, executor, ride, ride->fare, true};
+    }
+};
+
+// --------------------- Ride Manager -------------------------
+// Stand-ins for the driver and rider apps: answer delays, and how often they never answer.
+struct AppSimulation {
+    chrono::milliseconds driverAnswerDelay{chrono::seconds(2)};
+    chrono::milliseconds riderBoardingDelay{chrono::seconds(3)};
+    int lapsedOfferPercent = 0;
+    int noShowPercent = 0;
+
+    // Same roll for the same ride and person, so replays are repeatable.
+    static bool rolls(int percent, uint64_t rideId, const string& who) {
+        return percent > 0 && mix64(rideId ^ hash<string>{}(who)) % 100 < (uint64_t)percent;
+    }
+};
+
+class RideManager {
+private:
+    RideObject* currentRide;
+    GeoLocationManager* geoManager;
+    NotificationEngine* notificationEngine;
+    PaymentGateway* paymentGateway;
+    RideExecutor* executor;
+    ActiveRideIndex* activeRides;
+    IdempotencyCache* idempotencyCache;
+    DriverRatingStore* ratingStore;
+    RideTimeoutManager* timeouts;
+    AppSimulation* apps;
+
+    static constexpr int cancellationFee = 25;
+
+    // Past the free window a cancellation costs the fee; announced only if it can be charged.
+    bool chargesCancellationFee() {
+        return !currentRide->freeCancellation && paymentGateway;
+    }
+
+    // Stand-in for the driver app's location feed: walks the driver through the hops.
+    static RideTask simulateDriverRoute(RideExecutor* executor, GeoLocationManager* geoManager,
+                                        string driverName, vector<string> hops) {
+        for (size_t i = 0; i < hops.size(); i++) {
+            if (i > 0) co_await executor->sleepFor(chrono::seconds(2));
+            geoManager->updateDriverLocation(driverName, hops[i]);
+        }
+    }
+
+    // Stand-in for the rider app: reports the rider on board after a while.
+    static RideTask simulateRiderBoarding(RideExecutor* executor, ActiveRideIndex* activeRides, string riderName,
+                                          uint64_t rideId, chrono::milliseconds delay) {
+        co_await executor->sleepFor(delay);
+        activeRides->confirmBoarding(riderName, rideId);
+    }
+
+public:
+    // RideManager now accepts the RideObject and assumes it's ready for live management
+    RideManager(RideObject* ride, GeoLocationManager* gm, NotificationEngine* ne, PaymentGateway* pg, RideExecutor* ex,
+                ActiveRideIndex* ar, IdempotencyCache* ic, DriverRatingStore* rs, RideTimeoutManager* tm, AppSimulation* apps)
+        : currentRide(ride), geoManager(gm), notificationEngine(ne), paymentGateway(pg), executor(ex),
+          activeRides(ar), idempotencyCache(ic), ratingStore(rs), timeouts(tm), apps(apps) {}
+
+    // Spawns the live ride session; on success the session owns and deletes this RideManager.
+    bool startRide() {
+        if (!currentRide || currentRide->rideStatus != "driver_on_the_way") {
+            LOG_ERROR("[RideManager] Cannot start ride: invalid ride object or status.");
+            return false;
+        }
+
+        LOG_INFO("[RideManager] Starting live ride management for ride to {} with driver {}", currentRide->dest, currentRide->driverName);
+        executor->spawn(trackDriver());
+        return true;
+    }
+
+    // Charges a ride whose trip already completed; the session then owns this RideManager.
+    bool resumePayment() {
+        if (!currentRide || currentRide->rideStatus != "completed") {
+            LOG_ERROR("[RideManager] Cannot resume payment: ride is not completed.");
+            return false;
+        }
+        executor->spawn(settlePayment());
+        return true;
+    }
+
+    void notifyDriver(string message) {
+        LOG_INFO("[RideManager] Sending notification to driver {}: {}", currentRide->driverName, message);
+        notificationEngine->notifyDriver(message, currentRide->driverName);
+    }
+
+    void notifyUser(string message) {
+        LOG_INFO("[RideManager] Sending notification to user {}: {}", currentRide->name, message);
+        notificationEngine->notifyUser(message, currentRide->name);
+    }
+
+    void cancelRide() {
+        LOG_INFO("[RideManager] Ride cancelled.");
+        currentRide->setStatus("cancelled");
+        currentRide->cancelledAtMs = executor->getClock()->nowMs();
+        geoManager->unfollowDriver(currentRide->name, currentRide->driverName);
+        timeouts->disarmAll(currentRide);
+        ratingStore->releaseDriver(currentRide->driverName);
+        idempotencyCache->release(currentRide->idempotencyKey, currentRide->rideId); // a retry books afresh
+        notifyUser("Your ride has been cancelled.");
+        if (chargesCancellationFee()) {
+            currentRide->setFare(cancellationFee);
+            notifyUser("The free cancellation window had passed, a fee of " + to_string(cancellationFee) + " INR applies.");
+        }
+        notifyDriver("The ride for " + currentRide->name + " has been cancelled.");
+    }
+
+    // Cancels the ride; a new session charges any fee, retires the ride and owns this RideManager.
+    void endCancelled() {
+        cancelRide();
+        executor->spawn(settleCancellation());
+    }
+
+    RideTask trackDriver() {
+        string driverName = currentRide->driverName;
+        string userPickup = currentRide->start;
+        string userDestination = currentRide->dest;
+
+        // Driver moves towards pickup; the session sleeps until the driver reports in there
+        // or the rider cancels, which frees the driver at once
+        RideObject* ride = currentRide;
+        geoManager->resetTrail(driverName);
+        geoManager->followDriver(currentRide->name, driverName, userPickup);
+        LOG_INFO("[Live Ride] Driver {} is en route to {}.", driverName, userPickup);
+        uint64_t arrivalWatch = geoManager->watchArrival(driverName, userPickup, [ride] {
+            ride->pickupSignal.fire(PickupSignal::Arrived);
+        });
+        executor->spawn(simulateDriverRoute(executor, geoManager, driverName,
+                                            {"near_" + userPickup + "_1", "near_" + userPickup + "_2", userPickup}));
+        PickupSignal::Outcome approach = co_await ride->pickupSignal.wait(executor);
+        geoManager->unwatchArrival(driverName, arrivalWatch);
+        ride->pickupSignal.rearm();
+        if (approach != PickupSignal::Arrived || currentRide->cancelRequested) {
+            endCancelled();
+            co_return;
+        }
+
+        // Driver at pickup; wait until the rider boards, cancels or runs out the no-show timeout
+        currentRide->setStatus("driver_at_pickup");
+        currentRide->pickupAtMs = executor->getClock()->nowMs();
+        LOG_INFO("[Live Ride] Driver {} has arrived at {}.", driverName, userPickup);
+        notificationEngine->notify("driverArrived", currentRide, "Your driver " + currentRide->driverName + " has arrived at " + currentRide->start + ". Please board the vehicle.");
+        timeouts->arm(ride, RideTimeoutManager::PickupNoShow, timeouts->noShowTimeout, [ride] {
+            ride->pickupSignal.fire(PickupSignal::NoShow);
+        });
+        if (!AppSimulation::rolls(apps->noShowPercent, ride->rideId, ride->name)) {
+            executor->spawn(simulateRiderBoarding(executor, activeRides, ride->name, ride->rideId, apps->riderBoardingDelay));
+        }
+        PickupSignal::Outcome boarding = co_await ride->pickupSignal.wait(executor);
+        timeouts->disarm(ride, RideTimeoutManager::PickupNoShow);
+        if (boarding != PickupSignal::Boarded) {
+            if (boarding == PickupSignal::NoShow) {
+                LOG_INFO("[Live Ride] {} did not show up at {}.", currentRide->name, userPickup);
+                currentRide->freeCancellation = false; // the driver waited out the whole window
+            }
+            endCancelled();
+            co_return;
+        }
+
+        // Ride in progress until the driver reports in at the destination
+        currentRide->setStatus("in_progress");
+        geoManager->followDriver(currentRide->name, driverName, userDestination);
+        LOG_INFO("[Live Ride] Ride to {} is in progress.", userDestination);
+        executor->spawn(simulateDriverRoute(executor, geoManager, driverName,
+                                            {"midway_" + userDestination + "_1", "midway_" + userDestination + "_2", userDestination}));
+        co_await geoManager->arrivalAt(executor, driverName, userDestination);
+
+        // Ride completion
+        geoManager->unfollowDriver(currentRide->name, driverName);
+        currentRide->setStatus("completed");
+        currentRide->completedAtMs = executor->getClock()->nowMs();
+        LOG_INFO("[Live Ride] Ride to {} completed!", userDestination);
+        ratingStore->setDriverState(driverName, userDestination, true); // driver is free again where it dropped off
+        notificationEngine->notify("rideCompleted", currentRide, "Your ride with " + currentRide->driverName + " has successfully completed.");
+        // Explicitly notify driver of ride completion
+        notifyDriver("Ride for " + currentRide->name + " to " + currentRide->dest + " completed.");
+
+        // The payment session takes over this RideManager
+        executor->spawn(settlePayment());
+    }
+
+    RideTask settleCancellation() {
+        if (chargesCancellationFee()) {
+            co_await paymentGateway->chargeCancellationFee(executor, currentRide);
+        }
+        activeRides->retire(currentRide);
+        delete this;
+    }
+
+    RideTask settlePayment() {
+        //Initiate payment after ride completion
+        if (paymentGateway) {
+            co_await paymentGateway->processPayment(executor, currentRide, currentRide->fare); // Use fare from RideObject
+        } else {
+            LOG_WARN("[RideManager] Payment Gateway not configured.");
+        }
+        timeouts->disarmAll(currentRide);
+        activeRides->retire(currentRide);
+
+        // The session owns its manager once spawned; nothing touches *this after this point.
+        delete this;
+    }
+};
@@ -0,0 +1,218 @@
+#pragma once
+
+#include "rideExecutor.h"
+#include "rideObject.h"
+
+// --------------------- Ride timeouts (hierarchical timer wheel) -------------------------
+
+// Hierarchical timer wheel: four levels of 64 slots, cascaded down as lower levels wrap.
+// Timers are intrusive list nodes, so schedule and cancel are O(1).
+class TimerWheel {
+public:
+    struct Timer {
+        uint64_t expiryTick;
+        uint64_t owner;          // caller's key for the timer, e.g. a ride id
+        int tag;                 // caller's kind of timer
+        function<void()> callback;
+        Timer** slot = nullptr;  // head of the list the timer is on
+        Timer* prev = nullptr;
+        Timer* next = nullptr;
+    };
+
+private:
+    static constexpr int levels = 4;
+    static constexpr int slotBits = 6;
+    static constexpr uint64_t slotsPerLevel = 1ULL << slotBits;
+    static constexpr uint64_t slotMask = slotsPerLevel - 1;
+
+    Timer* slots[levels][slotsPerLevel] = {};
+    uint64_t currentTick;
+
+    void link(Timer* t) {
+        uint64_t delta = t->expiryTick > currentTick ? t->expiryTick - currentTick : 0;
+        int level = 0;
+        while (level < levels - 1 && delta >= (1ULL << (slotBits * (level + 1)))) level++;
+        uint64_t expiry = t->expiryTick;
+        if (delta >= (1ULL << (slotBits * levels))) expiry = currentTick + (1ULL << (slotBits * levels)) - 1; // parked at the far edge
+        Timer*& head = slots[level][(expiry >> (slotBits * level)) & slotMask];
+        t->slot = &head;
+        t->prev = nullptr;
+        t->next = head;
+        if (head) head->prev = t;
+        head = t;
+    }
+
+    void unlink(Timer* t) {
+        if (t->prev) {
+            t->prev->next = t->next;
+        } else {
+            *t->slot = t->next;
+        }
+        if (t->next) t->next->prev = t->prev;
+    }
+
+    // Detaches a whole slot and returns its list.
+    Timer* takeSlot(int level, uint64_t index) {
+        Timer* head = slots[level][index];
+        slots[level][index] = nullptr;
+        return head;
+    }
+
+public:
+    TimerWheel(uint64_t startTick) {
+        this->currentTick = startTick;
+    }
+
+    ~TimerWheel() {
+        for (int level = 0; level < levels; level++) {
+            for (auto head : slots[level]) {
+                while (head) {
+                    Timer* next = head->next;
+                    delete head;
+                    head = next;
+                }
+            }
+        }
+    }
+
+    uint64_t now() const {
+        return currentTick;
+    }
+
+    Timer* schedule(uint64_t delayTicks, uint64_t owner, int tag, function<void()> callback) {
+        Timer* t = new Timer();
+        t->expiryTick = currentTick + max<uint64_t>(delayTicks, 1);
+        t->owner = owner;
+        t->tag = tag;
+        t->callback = move(callback);
+        link(t);
+        return t;
+    }
+
+    void cancel(Timer* t) {
+        unlink(t);
+        delete t;
+    }
+
+    // Moves time forward to tick and returns the expired timers for the caller to run and delete.
+    vector<Timer*> advanceTo(uint64_t tick) {
+        vector<Timer*> fired;
+        while (currentTick < tick) {
+            currentTick++;
+            for (int level = 1; level < levels; level++) {
+                if ((currentTick & ((1ULL << (slotBits * level)) - 1)) != 0) break;
+                Timer* t = takeSlot(level, (currentTick >> (slotBits * level)) & slotMask);
+                while (t) {
+                    Timer* next = t->next;
+                    link(t);
+                    t = next;
+                }
+            }
+            Timer* t = takeSlot(0, currentTick & slotMask);
+            while (t) {
+                Timer* next = t->next;
+                if (t->expiryTick <= currentTick) {
+                    fired.push_back(t);
+                } else {
+                    link(t); // parked beyond the wheel's range; goes round again
+                }
+                t = next;
+            }
+        }
+        return fired;
+    }
+};
+
+// Accept deadlines, pickup no-shows and free-cancellation windows for every live ride.
+// Expiry callbacks run outside the lock, on the ticker thread or whoever calls advance().
+class RideTimeoutManager {
+public:
+    enum TimeoutKind { AcceptDeadline, PickupNoShow, CancellationWindow };
+
+private:
+    mutex mtx;
+    iClock* clock;
+    int64_t tickMs;
+    TimerWheel wheel;
+    unordered_map<uint64_t, unordered_map<int, TimerWheel::Timer*>> armed; // rideId -> kind -> timer
+    recursive_mutex firingMtx; // held while expiry callbacks run
+    thread ticker;
+    atomic<bool> stopping{false};
+
+    uint64_t tickAt(int64_t ms) const {
+        return (uint64_t)(ms / tickMs);
+    }
+
+public:
+    chrono::milliseconds acceptTimeout{chrono::seconds(15)};
+    chrono::milliseconds noShowTimeout{chrono::minutes(5)};
+    chrono::milliseconds freeCancellationWindow{chrono::minutes(2)};
+
+    RideTimeoutManager(iClock* clock, chrono::milliseconds tick)
+        : clock(clock), tickMs(tick.count()), wheel(clock->nowMs() / tick.count()) {}
+
+    // Live traffic: a background thread advances the wheel once per tick.
+    void start() {
+        ticker = thread([this] {
+            while (!stopping) {
+                this_thread::sleep_for(chrono::milliseconds(tickMs));
+                advance();
+            }
+        });
+    }
+
+    // (Re)arms one kind of timeout for the ride; onExpiry runs once unless disarmed first.
+    void arm(RideObject* r, TimeoutKind kind, chrono::milliseconds after, function<void()> onExpiry) {
+        lock_guard<mutex> lock(mtx);
+        auto& rideTimers = armed[r->rideId];
+        auto it = rideTimers.find(kind);
+        if (it != rideTimers.end()) wheel.cancel(it->second);
+        uint64_t delayTicks = (uint64_t)((after.count() + tickMs - 1) / tickMs);
+        rideTimers[kind] = wheel.schedule(delayTicks, r->rideId, kind, move(onExpiry));
+    }
+
+    void disarm(RideObject* r, TimeoutKind kind) {
+        lock_guard<mutex> lock(mtx);
+        auto rit = armed.find(r->rideId);
+        if (rit == armed.end()) return;
+        auto it = rit->second.find(kind);
+        if (it == rit->second.end()) return;
+        wheel.cancel(it->second);
+        rit->second.erase(it);
+        if (rit->second.empty()) armed.erase(rit);
+    }
+
+    // Also waits out a running expiry callback (unless called from one), so the ride can be retired.
+    void disarmAll(RideObject* r) {
+        lock_guard<recursive_mutex> firing(firingMtx);
+        lock_guard<mutex> lock(mtx);
+        auto rit = armed.find(r->rideId);
+        if (rit == armed.end()) return;
+        for (auto& kv : rit->second) wheel.cancel(kv.second);
+        armed.erase(rit);
+    }
+
+    // Fires every timeout that is due on the clock.
+    void advance() {
+        lock_guard<recursive_mutex> firing(firingMtx);
+        vector<function<void()>> fired;
+        {
+            lock_guard<mutex> lock(mtx);
+            for (TimerWheel::Timer* t : wheel.advanceTo(tickAt(clock->nowMs()))) {
+                auto rit = armed.find(t->owner);
+                if (rit != armed.end()) {
+                    rit->second.erase(t->tag);
+                    if (rit->second.empty()) armed.erase(rit);
+                }
+                fired.push_back(move(t->callback));
+                delete t;
+            }
+        }
+        for (auto& callback : fired) callback();
+    }
+
+    ~RideTimeoutManager() {
+        stopping = true;
+        if (ticker.joinable()) ticker.join();
+    }
+};
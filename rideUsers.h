@@ -0,0 +1,119 @@
+#pragma once
+
+#include "rideCommon.h"
+
+// ------------------------ User & Driver Classes ------------------------
+
+class Driver {
+public:
+    static constexpr const char* userType = "driver";
+    string name;
+    string vehicleType;
+    string currentLocation;
+    bool availability;
+    double rating; // decayed average kept up to date by DriverRatingStore
+    uint32_t fleetId; // row in the FleetTable
+
+    Driver(string name, string vehicleType) {
+        this->name = name;
+        this->vehicleType = vehicleType;
+        this->currentLocation = "";
+        this->availability = false;
+        this->rating = 0;
+        this->fleetId = 0;
+    }
+};
+
+class User {
+public:
+    static constexpr const char* userType = "user";
+    string name;
+    string phno;
+    string deviceId; // app install the account signed up from, "" if unknown
+    string currentLocation;
+    bool isOnline;
+
+    User(string name, string phno) {
+        this->name = name;
+        this->phno = phno;
+        this->deviceId = "";
+        this->currentLocation = "";
+        this->isOnline = false;
+    }
+};
+
+// ------------------------ auth,user,driver managers ------------------------
+
+class userManager {
+public:
+    vector<User*> users;
+    unordered_map<string, User*> usersByName;
+
+    void addUser(User* user) {
+        users.push_back(user);
+        usersByName[user->name] = user;
+    }
+
+    User* getUser(string username) {
+        auto it = usersByName.find(username);
+        return it == usersByName.end() ? nullptr : it->second;
+    }
+    ~userManager() {
+        for (User* u : users) {
+            delete u;
+        }
+        users.clear();
+    }
+};
+
+class driverManager {
+public:
+    vector<Driver*> drivers;
+
+    void addDriver(Driver* driver) {
+        drivers.push_back(driver);
+    }
+
+    Driver* getDriver(string username) {
+        for (auto* driver : drivers) {
+            if (driver->name == username) return driver;
+        }
+        return nullptr;
+    }
+    ~driverManager() {
+        for (Driver* d : drivers) {
+            delete d;
+        }
+        drivers.clear();
+    }
+};
+
+class AuthManager {
+private:
+    userManager* um;
+    driverManager* dm;
+    function<bool(const string&)> admitLogin; // rate limit per username; empty: no limit
+
+public:
+    AuthManager(userManager* um, driverManager* dm, function<bool(const string&)> admitLogin = nullptr) {
+        this->um = um;
+        this->dm = dm;
+        this->admitLogin = admitLogin;
+    }
+
+    void login(string username) {
+        if (admitLogin && !admitLogin(username)) {
+            cout << "Too many login attempts for " << username << ". Try again later.\n";
+            return;
+        }
+        if (User* u = um->getUser(username)) {
+            u->isOnline = true;
+            cout << "User " << u->name << " logged in.\n";
+        } else if (Driver* d = dm->getDriver(username)) {
+            d->availability = true;
+            cout << "Driver " << d->name << " logged in.\n";
+        } else {
+            cout << "Login failed for " << username << "\n";
+        }
+    }
+};
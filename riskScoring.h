@@ -0,0 +1,241 @@
+#pragma once
+
+#include "rideUsers.h"
+#include "rideExecutor.h"
+#include "geoLocation.h"
+#include "rideObject.h"
+#include "bookingSubject.h"
+
+// ------------------------ Risk scoring (fraud and anomaly signals) ------------------------
+
+inline uint64_t mix64(uint64_t x) {
+    x += 0x9E3779B97F4A7C15ull;
+    x = (x ^ (x >> 30)) * 0xBF58476D1CE4E5B9ull;
+    x = (x ^ (x >> 27)) * 0x94D049BB133111EBull;
+    return x ^ (x >> 31);
+}
+
+// Approximate per-key counters in fixed memory (count-min with conservative update).
+// Estimates never undercount; counters saturate instead of wrapping.
+template <typename Counter>
+class CountMinSketch {
+    size_t width;
+    size_t depth;
+    vector<Counter> counters; // depth rows of width counters
+
+    size_t cellFor(uint64_t keyHash, size_t row) const {
+        return row * width + mix64(keyHash + row) % width;
+    }
+
+public:
+    CountMinSketch(size_t width, size_t depth) : width(width), depth(depth), counters(width * depth, 0) {}
+
+    void add(uint64_t keyHash) {
+        Counter current = estimate(keyHash);
+        if (current == numeric_limits<Counter>::max()) return;
+        for (size_t row = 0; row < depth; row++) {
+            Counter& c = counters[cellFor(keyHash, row)];
+            if (c == current) c++;
+        }
+    }
+
+    Counter estimate(uint64_t keyHash) const {
+        Counter best = numeric_limits<Counter>::max();
+        for (size_t row = 0; row < depth; row++) best = min(best, counters[cellFor(keyHash, row)]);
+        return best;
+    }
+
+    void clear() {
+        fill(counters.begin(), counters.end(), 0);
+    }
+};
+
+// Distinct items per key in fixed memory: a small HyperLogLog per key in an open-addressing
+// table; a full probe window evicts its lowest estimate.
+class DistinctCountTable {
+    static constexpr size_t registers = 32; // ~18% standard error; exact-ish for small counts
+    static constexpr int indexBits = 5;     // log2(registers)
+    static constexpr size_t probeWindow = 8;
+
+    struct Slot {
+        uint64_t key = 0; // 0: free
+        uint8_t rank[registers] = {};
+    };
+
+    vector<Slot> slots;
+    size_t mask;
+
+    static uint32_t estimateOf(const Slot& s) {
+        double sum = 0;
+        size_t zeros = 0;
+        for (uint8_t r : s.rank) {
+            sum += ldexp(1.0, -r);
+            if (r == 0) zeros++;
+        }
+        double m = (double)registers;
+        double e = 0.697 * m * m / sum;
+        if (e <= 2.5 * m && zeros > 0) e = m * log(m / (double)zeros); // linear counting for small sets
+        return (uint32_t)llround(e);
+    }
+
+    Slot* find(uint64_t key) {
+        for (size_t i = 0; i < probeWindow; i++) {
+            Slot& s = slots[(mix64(key) + i) & mask];
+            if (s.key == key) return &s;
+        }
+        return nullptr;
+    }
+
+public:
+    // capacity is rounded up to a power of two.
+    DistinctCountTable(size_t capacity) {
+        size_t n = probeWindow;
+        while (n < capacity) n <<= 1;
+        slots.resize(n);
+        mask = n - 1;
+    }
+
+    void add(uint64_t keyHash, uint64_t itemHash) {
+        uint64_t key = keyHash | 1;
+        Slot* s = find(key);
+        if (!s) {
+            for (size_t i = 0; i < probeWindow && !s; i++) {
+                Slot& candidate = slots[(mix64(key) + i) & mask];
+                if (candidate.key == 0) s = &candidate;
+            }
+            if (!s) {
+                s = &slots[mix64(key) & mask];
+                for (size_t i = 1; i < probeWindow; i++) {
+                    Slot& candidate = slots[(mix64(key) + i) & mask];
+                    if (estimateOf(candidate) < estimateOf(*s)) s = &candidate;
+                }
+            }
+            *s = Slot();
+            s->key = key;
+        }
+        uint64_t h = mix64(itemHash);
+        uint64_t rest = h >> indexBits;
+        uint8_t rank = (uint8_t)(rest ? __builtin_ctzll(rest) + 1 : 64 - indexBits + 1);
+        uint8_t& r = s->rank[h % registers];
+        r = max(r, rank);
+    }
+
+    uint32_t estimate(uint64_t keyHash) {
+        Slot* s = find(keyHash | 1);
+        return s ? estimateOf(*s) : 0;
+    }
+};
+
+// Scores a finished ride before it is charged: GPS jumps on the trip's trail, repeated
+// bookings by the rider, and many accounts on the rider's phone or device.
+class RiskScorer : public iBookingObserver {
+public:
+    enum Decision { Approve, Review, Hold };
+
+    struct Assessment {
+        int score = 0; // 0..100
+        Decision decision = Approve;
+        string reasons;
+    };
+
+private:
+    mutex mtx;
+    iClock* clock;
+    GeoLocationManager* gm;
+    userManager* um;
+    int64_t windowMs;
+    int64_t windowStart;
+    CountMinSketch<uint16_t> bookingsThisWindow{1 << 16, 4}; // 512 KB each
+    CountMinSketch<uint16_t> bookingsLastWindow{1 << 16, 4};
+    DistinctCountTable accountsPerPhone{1 << 14};            // 640 KB each
+    DistinctCountTable accountsPerDevice{1 << 14};
+
+    static constexpr uint32_t bookingsAllowed = 10;  // per rider per window
+    static constexpr uint32_t accountsAllowed = 3;   // per phone number or device
+
+    static uint64_t keyOf(const string& s) {
+        return (uint64_t)hash<string>{}(s);
+    }
+
+    // Caller holds mtx. Starts a new window once the current one is over.
+    void rotateWindows(int64_t now) {
+        if (now - windowStart < windowMs) return;
+        if (now - windowStart >= 2 * windowMs) {
+            bookingsLastWindow.clear(); // idle for more than a window: nothing recent left
+        } else {
+            swap(bookingsLastWindow, bookingsThisWindow);
+        }
+        bookingsThisWindow.clear();
+        windowStart = now - (now - windowStart) % windowMs;
+    }
+
+    static void addReason(Assessment& a, int points, const string& reason) {
+        a.score += points;
+        if (!a.reasons.empty()) a.reasons += "; ";
+        a.reasons += reason;
+    }
+
+public:
+    static const char* describe(Decision d) {
+        switch (d) {
+            case Approve: return "approve";
+            case Review: return "review";
+            case Hold: return "hold";
+        }
+        return "unknown";
+    }
+
+    int reviewScore = 40;
+    int holdScore = 70;
+
+    RiskScorer(iClock* clock, GeoLocationManager* gm, userManager* um, chrono::milliseconds window)
+        : clock(clock), gm(gm), um(um), windowMs(window.count()), windowStart(clock->nowMs()) {}
+
+    // Account registration; feeds the accounts-per-phone and per-device signals.
+    void recordAccount(const User* u) {
+        lock_guard<mutex> lock(mtx);
+        accountsPerPhone.add(keyOf(u->phno), keyOf(u->name));
+        if (!u->deviceId.empty()) accountsPerDevice.add(keyOf(u->deviceId), keyOf(u->name));
+    }
+
+    void notifyBookingDetails(RideObject* r) override {
+        lock_guard<mutex> lock(mtx);
+        rotateWindows(clock->nowMs());
+        bookingsThisWindow.add(keyOf(r->name));
+    }
+
+    Assessment score(RideObject* r) {
+        // Location lookups take the location lock; do them before taking ours
+        uint32_t jumps = gm->gpsJumps(r->driverName);
+        User* rider = um->getUser(r->name);
+
+        Assessment a;
+        lock_guard<mutex> lock(mtx);
+        rotateWindows(clock->nowMs());
+
+        if (jumps > 0) {
+            addReason(a, min<int>(40 * jumps, 60), to_string(jumps) + " improbable GPS jump(s) on the trip");
+        }
+
+        uint64_t riderKey = keyOf(r->name);
+        uint32_t bookings = bookingsThisWindow.estimate(riderKey) + bookingsLastWindow.estimate(riderKey);
+        if (bookings > bookingsAllowed) {
+            addReason(a, min<int>(10 * (bookings - bookingsAllowed), 40), to_string(bookings) + " recent bookings");
+        }
+
+        if (rider) {
+            uint32_t accounts = accountsPerPhone.estimate(keyOf(rider->phno));
+            if (accounts > accountsAllowed) {
+                addReason(a, min<int>(15 * (accounts - accountsAllowed), 45), to_string(accounts) + " accounts share the phone number");
+            }
+            accounts = rider->deviceId.empty() ? 0 : accountsPerDevice.estimate(keyOf(rider->deviceId));
+            if (accounts > accountsAllowed) {
+                addReason(a, min<int>(15 * (accounts - accountsAllowed), 45), to_string(accounts) + " accounts share the device");
+            }
+        }
+
+        a.score = min(a.score, 100);
+        a.decision = a.score >= holdScore ? Hold : a.score >= reviewScore ? Review : Approve;
+        return a;
+    }
+};
@@ -0,0 +1,366 @@
+#pragma once
+
+#include "rideUsers.h"
+#include "rideExecutor.h"
+#include "fleetTable.h"
+#include "geoLocation.h"
+#include "rideObject.h"
+#include "rideIdentity.h"
+#include "driverAllocation.h"
+#include "traceReplay.h"
+
+// ------------------------ Snapshots (checkpoint & fast restart) ------------------------
+
+// Binary snapshot of users, drivers, locations and live rides: fixed-size records plus a string
+// pool, mapped and read in place. Written to <path>.tmp and renamed over the previous one.
+class SnapshotStore {
+public:
+    static constexpr uint32_t formatVersion = 3;
+
+private:
+    struct StrRef {
+        uint32_t offset;
+        uint32_t length;
+    };
+
+    struct Header {
+        char magic[8];
+        uint32_t version;
+        uint32_t headerSize;
+        int64_t createdAtMs;
+        int64_t clockAtMs; // the ride clock when the snapshot was taken
+        uint64_t userCount, driverCount, userLocationCount, driverLocationCount, rideCount;
+        uint64_t usersOffset, driversOffset, userLocationsOffset, driverLocationsOffset, ridesOffset;
+        uint64_t stringsOffset, stringsSize;
+    };
+
+    struct UserRecord {
+        StrRef name, phno, deviceId, location;
+        uint8_t online;
+        uint8_t pad[7];
+    };
+
+    struct DriverRecord {
+        StrRef name, vehicleType, location;
+        double rating;
+        uint8_t available;
+        uint8_t pad[7];
+    };
+
+    struct LocationRecord {
+        StrRef name, location;
+    };
+
+    struct RideRecord {
+        uint64_t rideId;
+        StrRef name, start, dest, rideType, vehicle, vehicleType, driverName, status, idempotencyKey;
+        StrRef pricing, pickupZone, destZone;
+        StrRef excludedDrivers; // '\n'-separated
+        int64_t requestedAtMs, matchedAtMs, acceptedAtMs, pickupAtMs, completedAtMs;
+        int32_t fare;
+        uint8_t freeCancellation;
+        uint8_t pad[3];
+    };
+
+    // Collects records and a deduplicated string pool, then lays them out as one file image.
+    class Builder {
+        vector<UserRecord> users;
+        vector<DriverRecord> drivers;
+        vector<LocationRecord> userLocations, driverLocations;
+        vector<RideRecord> rides;
+        string strings;
+        unordered_map<string, StrRef> interned;
+
+        template <typename T>
+        static void appendSection(vector<uint8_t>& out, const vector<T>& records, uint64_t& offset) {
+            out.resize((out.size() + 7) & ~size_t(7));
+            offset = out.size();
+            const uint8_t* bytes = (const uint8_t*)records.data();
+            out.insert(out.end(), bytes, bytes + records.size() * sizeof(T));
+        }
+
+    public:
+        StrRef intern(const string& s) {
+            auto it = interned.find(s);
+            if (it != interned.end()) return it->second;
+            StrRef ref{(uint32_t)strings.size(), (uint32_t)s.size()};
+            strings += s;
+            interned.emplace(s, ref);
+            return ref;
+        }
+
+        void addUser(const User* u) {
+            UserRecord rec{};
+            rec.name = intern(u->name);
+            rec.phno = intern(u->phno);
+            rec.deviceId = intern(u->deviceId);
+            rec.location = intern(u->currentLocation);
+            rec.online = u->isOnline;
+            users.push_back(rec);
+        }
+
+        void addDriver(const Driver* d) {
+            DriverRecord rec{};
+            rec.name = intern(d->name);
+            rec.vehicleType = intern(d->vehicleType);
+            rec.location = intern(d->currentLocation);
+            rec.rating = d->rating;
+            rec.available = d->availability;
+            drivers.push_back(rec);
+        }
+
+        void addLocation(bool driver, const string& name, const string& location) {
+            (driver ? driverLocations : userLocations).push_back({intern(name), intern(location)});
+        }
+
+        void addRide(const RideObject* r) {
+            RideRecord rec{};
+            rec.rideId = r->rideId;
+            rec.name = intern(r->name);
+            rec.start = intern(r->start);
+            rec.dest = intern(r->dest);
+            rec.rideType = intern(r->rideType);
+            rec.vehicle = intern(r->vehicle);
+            rec.vehicleType = intern(r->vehicleType);
+            rec.driverName = intern(r->driverName);
+            rec.status = intern(r->rideStatus);
+            rec.idempotencyKey = intern(r->idempotencyKey);
+            rec.pricing = intern(r->pricing);
+            rec.pickupZone = intern(r->pickupZone);
+            rec.destZone = intern(r->destZone);
+            string excluded;
+            for (const string& d : r->excludedDrivers) excluded += (excluded.empty() ? "" : "\n") + d;
+            rec.excludedDrivers = intern(excluded);
+            rec.requestedAtMs = r->requestedAtMs;
+            rec.matchedAtMs = r->matchedAtMs;
+            rec.acceptedAtMs = r->acceptedAtMs;
+            rec.pickupAtMs = r->pickupAtMs;
+            rec.completedAtMs = r->completedAtMs;
+            rec.fare = r->fare;
+            rec.freeCancellation = r->freeCancellation;
+            rides.push_back(rec);
+        }
+
+        vector<uint8_t> finish(int64_t createdAtMs, int64_t clockAtMs) {
+            Header h{};
+            memcpy(h.magic, "RIDESNAP", 8);
+            h.version = formatVersion;
+            h.headerSize = sizeof(Header);
+            h.createdAtMs = createdAtMs;
+            h.clockAtMs = clockAtMs;
+            h.userCount = users.size();
+            h.driverCount = drivers.size();
+            h.userLocationCount = userLocations.size();
+            h.driverLocationCount = driverLocations.size();
+            h.rideCount = rides.size();
+            vector<uint8_t> out(sizeof(Header));
+            appendSection(out, users, h.usersOffset);
+            appendSection(out, drivers, h.driversOffset);
+            appendSection(out, userLocations, h.userLocationsOffset);
+            appendSection(out, driverLocations, h.driverLocationsOffset);
+            appendSection(out, rides, h.ridesOffset);
+            h.stringsOffset = out.size();
+            h.stringsSize = strings.size();
+            out.insert(out.end(), strings.begin(), strings.end());
+            memcpy(out.data(), &h, sizeof(Header));
+            return out;
+        }
+    };
+
+    string path;
+    iClock* clock; // the executor's clock, which ride milestones are on
+    userManager* um;
+    driverManager* dm;
+    GeoLocationManager* gm;
+    ActiveRideIndex* activeRides;
+    DriverRatingStore* ratingStore;
+    mutex checkpointMtx; // one checkpoint at a time (periodic thread and shutdown)
+    thread periodic;
+    thread writer;
+    atomic<bool> writing{false};
+    bool lastWriteOk = true;
+    mutex periodicMtx;
+    condition_variable periodicCv;
+    bool stopping = false;
+
+    // Caller holds the active ride index lock; each ride is copied under its own lock.
+    vector<unique_lock<mutex>> lockLiveRides() {
+        vector<unique_lock<mutex>> locks;
+        for (auto& entry : activeRides->ridesLocked()) locks.push_back(entry.second->lockState());
+        return locks;
+    }
+
+    // Caller holds the state locks.
+    vector<uint8_t> buildImage() {
+        Builder b;
+        for (const User* u : um->users) b.addUser(u);
+        for (const Driver* d : dm->drivers) b.addDriver(d);
+        for (auto& entry : gm->usersLocations) b.addLocation(false, entry.first, entry.second);
+        for (auto& entry : gm->driverLocations) b.addLocation(true, entry.first, entry.second);
+        for (auto& entry : activeRides->ridesLocked()) b.addRide(entry.second);
+        int64_t now = chrono::duration_cast<chrono::milliseconds>(chrono::system_clock::now().time_since_epoch()).count();
+        return b.finish(now, clock->nowMs());
+    }
+
+    static bool writeFile(const string& path, const vector<uint8_t>& image) {
+        string tmp = path + ".tmp";
+        ofstream out(tmp, ios::binary | ios::trunc);
+        if (!out) return false;
+        out.write((const char*)image.data(), (streamsize)image.size());
+        out.close();
+        if (!out) return false;
+        error_code ec;
+        filesystem::rename(tmp, path, ec); // replaces the previous snapshot
+        return !ec;
+    }
+
+    static string_view str(string_view file, const Header& h, StrRef ref) {
+        if (ref.offset + (uint64_t)ref.length > h.stringsSize) return string_view();
+        return file.substr(h.stringsOffset + ref.offset, ref.length);
+    }
+
+    template <typename T>
+    static const T* section(string_view file, uint64_t offset, uint64_t count) {
+        if (offset % 8 != 0 || offset > file.size() || count > (file.size() - offset) / sizeof(T)) return nullptr;
+        return (const T*)(file.data() + offset);
+    }
+
+public:
+    SnapshotStore(string path, iClock* clock, userManager* um, driverManager* dm, GeoLocationManager* gm, ActiveRideIndex* ar,
+                  DriverRatingStore* rs)
+        : path(path), clock(clock), um(um), dm(dm), gm(gm), activeRides(ar), ratingStore(rs) {}
+
+    // Starts a background checkpoint; false if the previous one is still being written.
+    bool checkpoint() {
+        lock_guard<mutex> lock(checkpointMtx);
+        if (writing) return false;
+        if (writer.joinable()) writer.join();
+        vector<uint8_t> image;
+        {
+            auto ratingLock = ratingStore->lockState();
+            auto geoLock = gm->lockState();
+            auto ridesLock = activeRides->lockState();
+            auto rideLocks = lockLiveRides();
+            image = buildImage();
+        }
+        writing = true;
+        writer = thread([this, image = move(image)] {
+            lastWriteOk = writeFile(path, image);
+            writing = false;
+        });
+        return true;
+    }
+
+    // Blocks until the last checkpoint is on disk; returns whether it was written.
+    bool waitForCheckpoint() {
+        lock_guard<mutex> lock(checkpointMtx);
+        if (writer.joinable()) writer.join();
+        return lastWriteOk;
+    }
+
+    void startPeriodic(chrono::seconds interval) {
+        periodic = thread([this, interval] {
+            unique_lock<mutex> lock(periodicMtx);
+            while (!periodicCv.wait_for(lock, interval, [this] { return stopping; })) {
+                lock.unlock();
+                checkpoint();
+                lock.lock();
+            }
+        });
+    }
+
+    // Restores users, drivers and locations; live rides are returned for the caller to
+    // resume, their milestones moved onto clock.
+    static bool load(const string& path, iClock* clock, userManager* um, driverManager* dm, FleetTable* fleet, GeoLocationManager* gm,
+                     vector<RideObject*>& rides) {
+        MappedTraceFile file;
+        if (!file.open(path)) return false;
+        string_view data = file.contents();
+        // Through section() like every other record, so the size check and the read are one step
+        const Header* mapped = section<Header>(data, 0, 1);
+        if (!mapped) return false;
+        const Header h = *mapped;
+        if (memcmp(h.magic, "RIDESNAP", 8) != 0 || h.version != formatVersion || h.headerSize != sizeof(Header) ||
+            h.stringsOffset > data.size() || h.stringsSize > data.size() - h.stringsOffset) {
+            return false;
+        }
+        const UserRecord* users = section<UserRecord>(data, h.usersOffset, h.userCount);
+        const DriverRecord* drivers = section<DriverRecord>(data, h.driversOffset, h.driverCount);
+        const LocationRecord* userLocations = section<LocationRecord>(data, h.userLocationsOffset, h.userLocationCount);
+        const LocationRecord* driverLocations = section<LocationRecord>(data, h.driverLocationsOffset, h.driverLocationCount);
+        const RideRecord* rideRecords = section<RideRecord>(data, h.ridesOffset, h.rideCount);
+        if (!users || !drivers || !userLocations || !driverLocations || !rideRecords) return false;
+
+        um->users.reserve(um->users.size() + h.userCount);
+        for (uint64_t i = 0; i < h.userCount; i++) {
+            const UserRecord& rec = users[i];
+            User* u = new User(string(str(data, h, rec.name)), string(str(data, h, rec.phno)));
+            u->deviceId = string(str(data, h, rec.deviceId));
+            u->currentLocation = string(str(data, h, rec.location));
+            u->isOnline = rec.online;
+            um->addUser(u);
+        }
+        dm->drivers.reserve(dm->drivers.size() + h.driverCount);
+        for (uint64_t i = 0; i < h.driverCount; i++) {
+            const DriverRecord& rec = drivers[i];
+            Driver* d = new Driver(string(str(data, h, rec.name)), string(str(data, h, rec.vehicleType)));
+            d->currentLocation = string(str(data, h, rec.location));
+            d->availability = rec.available;
+            d->rating = rec.rating;
+            dm->addDriver(d);
+            fleet->addDriver(d);
+        }
+        for (uint64_t i = 0; i < h.userLocationCount; i++) {
+            gm->storeLocation(string(str(data, h, userLocations[i].name)), User::userType, string(str(data, h, userLocations[i].location)));
+        }
+        for (uint64_t i = 0; i < h.driverLocationCount; i++) {
+            gm->storeLocation(string(str(data, h, driverLocations[i].name)), Driver::userType, string(str(data, h, driverLocations[i].location)));
+        }
+        int64_t wallNow = chrono::duration_cast<chrono::milliseconds>(chrono::system_clock::now().time_since_epoch()).count();
+        int64_t shift = clock->nowMs() - max<int64_t>(wallNow - h.createdAtMs, 0) - h.clockAtMs;
+        auto rebase = [shift](int64_t ms) { return ms == 0 ? 0 : ms + shift; };
+        for (uint64_t i = 0; i < h.rideCount; i++) {
+            const RideRecord& rec = rideRecords[i];
+            RideObject* r = new RideObject(string(str(data, h, rec.start)), string(str(data, h, rec.dest)), string(str(data, h, rec.name)),
+                                           string(str(data, h, rec.vehicle)), string(str(data, h, rec.vehicleType)));
+            r->rideId = rec.rideId;
+            r->rideType = string(str(data, h, rec.rideType));
+            r->driverName = string(str(data, h, rec.driverName));
+            r->rideStatus = string(str(data, h, rec.status));
+            r->idempotencyKey = string(str(data, h, rec.idempotencyKey));
+            r->pricing = string(str(data, h, rec.pricing));
+            r->pickupZone = string(str(data, h, rec.pickupZone));
+            r->destZone = string(str(data, h, rec.destZone));
+            string_view excluded = str(data, h, rec.excludedDrivers);
+            while (!excluded.empty()) {
+                size_t eol = excluded.find('\n');
+                r->excludedDrivers.push_back(string(excluded.substr(0, eol)));
+                excluded = eol == string_view::npos ? string_view() : excluded.substr(eol + 1);
+            }
+            r->requestedAtMs = rebase(rec.requestedAtMs);
+            r->matchedAtMs = rebase(rec.matchedAtMs);
+            r->acceptedAtMs = rebase(rec.acceptedAtMs);
+            r->pickupAtMs = rebase(rec.pickupAtMs);
+            r->completedAtMs = rebase(rec.completedAtMs);
+            r->fare = rec.fare;
+            r->freeCancellation = rec.freeCancellation != 0;
+            rides.push_back(r);
+        }
+        // Restored rides restart from matching, so the drivers they held are free again
+        for (RideObject* r : rides) {
+            if (r->driverName.empty()) continue;
+            if (Driver* d = dm->getDriver(r->driverName)) d->availability = true;
+        }
+        return true;
+    }
+
+    ~SnapshotStore() {
+        {
+            lock_guard<mutex> lock(periodicMtx);
+            stopping = true;
+        }
+        periodicCv.notify_all();
+        if (periodic.joinable()) periodic.join();
+        waitForCheckpoint();
+    }
+};
@@ -0,0 +1,328 @@
+#pragma once
+
+#include "rideLogger.h"
+#include "rideUsers.h"
+#include "rideExecutor.h"
+#include "fleetTable.h"
+#include "geoLocation.h"
+#include "rideObject.h"
+#include "rideIdentity.h"
+#include "rideTimeouts.h"
+#include "bookingFactories.h"
+#include "rideConfig.h"
+#include "priceCalculator.h"
+#include "bookingSubject.h"
+#include "driverAllocation.h"
+#include "notifications.h"
+#include "allocationOrchestrator.h"
+#include "demandForecast.h"
+#include "rideSession.h"
+#include "rideRequests.h"
+
+// ------------------------ Trace replay / simulation mode ------------------------
+
+// Trace files are CSV, one event per line, ordered by time (lines starting with '#' are ignored):
+//   <ms>,driver,<name>,<vehicleType>,<location>        driver comes online
+//   <ms>,location,<name>,<userType>,<location>         location report through statusListner
+//   <ms>,booking,<user>,<start>,<dest>,<rideType>,<vehicle>
+//   <ms>,cancel,<user>                                  rider cancels their live ride
+//   <ms>,rating,<driver>,<stars>
+
+// Read-only view of a trace file, memory-mapped where the platform allows it.
+class MappedTraceFile {
+private:
+    const char* data = nullptr;
+    size_t size = 0;
+#ifdef _WIN32
+    string buffer;
+#else
+    void* mapping = nullptr;
+#endif
+
+public:
+    bool open(const string& path) {
+#ifdef _WIN32
+        ifstream in(path, ios::binary);
+        if (!in) return false;
+        buffer.assign(istreambuf_iterator<char>(in), istreambuf_iterator<char>());
+        data = buffer.data();
+        size = buffer.size();
+        return true;
+#else
+        int fd = ::open(path.c_str(), O_RDONLY);
+        if (fd < 0) return false;
+        struct stat st;
+        if (fstat(fd, &st) != 0) {
+            ::close(fd);
+            return false;
+        }
+        size = (size_t)st.st_size;
+        if (size > 0) {
+            mapping = mmap(nullptr, size, PROT_READ, MAP_PRIVATE, fd, 0);
+            if (mapping == MAP_FAILED) {
+                mapping = nullptr;
+                ::close(fd);
+                return false;
+            }
+            madvise(mapping, size, MADV_SEQUENTIAL);
+            data = (const char*)mapping;
+        }
+        ::close(fd);
+        return true;
+#endif
+    }
+
+    string_view contents() const {
+        return string_view(data ? data : "", size);
+    }
+
+    ~MappedTraceFile() {
+#ifndef _WIN32
+        if (mapping) munmap(mapping, size);
+#endif
+    }
+};
+
+// Times the wrapped orchestrator so replays can report allocation latency.
+class TimedAllocationOrchestrator : public IDriverAllocationOrchestrator {
+    IDriverAllocationOrchestrator* inner;
+public:
+    vector<int64_t> matchNanos;
+
+    TimedAllocationOrchestrator(IDriverAllocationOrchestrator* inner) {
+        this->inner = inner;
+    }
+
+    void orchestrate(RideObject* r) override {
+        auto t0 = chrono::steady_clock::now();
+        inner->orchestrate(r);
+        matchNanos.push_back(chrono::duration_cast<chrono::nanoseconds>(chrono::steady_clock::now() - t0).count());
+    }
+};
+
+// Keeps every ride that made it past intake so metrics can be read once the replay ends.
+class ReplayRideCollector : public iBookingObserver {
+public:
+    vector<RideObject*> rides;
+
+    void notifyBookingDetails(RideObject* r) override {
+        rides.push_back(r);
+    }
+};
+
+struct ReplayMetrics {
+    string strategy;
+    size_t events = 0;
+    size_t bookings = 0;
+    size_t accepted = 0;      // past intake (not a duplicate or a second live ride)
+    size_t matched = 0;
+    size_t completed = 0;
+    size_t cancelled = 0;
+    double matchP50Us = 0;
+    double matchP95Us = 0;
+    double pickupEtaP50S = 0;
+    double pickupEtaP95S = 0;
+    double utilization = 0;   // share of fleet time spent on rides
+    size_t repositionSuggestions = 0;
+    int64_t simulatedMs = 0;
+    double wallMs = 0;
+};
+
+// Replays a trace through a fresh BookingManager, statusListner and RideManager on a virtual clock.
+class ReplaySimulator {
+private:
+    static vector<string_view> splitFields(string_view line) {
+        vector<string_view> fields;
+        size_t pos = 0;
+        while (true) {
+            size_t comma = line.find(',', pos);
+            fields.push_back(line.substr(pos, comma == string_view::npos ? string_view::npos : comma - pos));
+            if (comma == string_view::npos) break;
+            pos = comma + 1;
+        }
+        return fields;
+    }
+
+    static int64_t toInt(string_view field) {
+        int64_t value = 0;
+        from_chars(field.data(), field.data() + field.size(), value);
+        return value;
+    }
+
+    template <typename T>
+    static double percentile(vector<T> values, double p) {
+        if (values.empty()) return 0;
+        size_t idx = (size_t)(p * (values.size() - 1));
+        nth_element(values.begin(), values.begin() + idx, values.end());
+        return (double)values[idx];
+    }
+
+public:
+    ReplayMetrics run(string_view trace, const string& strategyName) {
+        ReplayMetrics m;
+        m.strategy = strategyName;
+        auto wallStart = chrono::steady_clock::now();
+
+        VirtualClock clock;
+        RideExecutor executor(&clock);
+        FleetTable fleetTable;
+        GeoLocationManager gm(&clock, &fleetTable, nullptr);
+        addCityPlaces(&gm);
+        statusListner status;
+        polling pollingObs(&gm);
+        status.addObserver(&pollingObs);
+
+        NotificationSubject notifSubject;
+        UserNotificationObserver userNotifObs;
+        DriverNotificationObserver driverNotifObs;
+        notifSubject.addObserver(&userNotifObs);
+        notifSubject.addObserver(&driverNotifObs);
+        ConfigStore config; // built-in defaults; the strategy under test is passed explicitly
+        NotificationEngine notifEngine(&notifSubject, &config);
+        PaymentGateway paymentGateway(nullptr, nullptr);
+
+        RideIdGenerator rideIds(1);
+        IdempotencyCache idempotencyCache(chrono::seconds(30), &clock);
+        ActiveRideIndex activeRides([](RideObject*) {}); // every ride is kept for the metrics, see ReplayRideCollector
+        RideTimeoutManager timeouts(&clock, chrono::milliseconds(100));
+        DriverRatingStore ratingStore(chrono::hours(24 * 30), &fleetTable, &gm);
+        idleIndexFeed idleFeed(&gm, &ratingStore);
+        status.addObserver(&idleFeed);
+        driverManager dm;
+        unordered_map<string, Driver*> fleet; // name lookup without driverManager's linear scan
+
+        DriverAllocationStrategySelector strategySelector(&ratingStore, &fleetTable, &gm, nullptr);
+        ConcreteDriverAllocationOrchestrator orchestrator(&notifEngine, &strategySelector, strategyName);
+        TimedAllocationOrchestrator timedOrchestrator(&orchestrator);
+
+        RideTypeFactorySelector rideTypeSelector;
+        VehicleFactorySelector vehicleSelector;
+        ConcretePriceCalculator priceCalc(&config, nullptr);
+
+        // The booking subject belongs to the BookingManager, its observers to this replay
+        BookingSubject* bookingSubject = new BookingSubject();
+        ReplayRideCollector* collector = new ReplayRideCollector();
+        RideRequestManager* rideRequestManager = new RideRequestManager(&notifEngine, &gm, &paymentGateway, &timedOrchestrator,
+                                                                        &executor, &activeRides, &idempotencyCache, &ratingStore,
+                                                                        &timeouts, nullptr); // allocation inline keeps the replay deterministic
+        bookingSubject->addObservers(collector);
+        DemandForecaster* forecaster = new DemandForecaster(&clock, &gm, &ratingStore, &notifEngine, chrono::minutes(1));
+        bookingSubject->addObservers(forecaster);
+        bookingSubject->addObservers(rideRequestManager); // hands the ride over, so last
+        BookingManager bm(&rideTypeSelector, &vehicleSelector, &priceCalc, bookingSubject,
+                          &rideIds, &idempotencyCache, &activeRides, nullptr, nullptr); // traces replay every booking
+
+        int64_t firstMs = -1;
+        size_t pos = 0;
+        while (pos < trace.size()) {
+            size_t eol = trace.find('\n', pos);
+            string_view line = trace.substr(pos, eol == string_view::npos ? string_view::npos : eol - pos);
+            pos = eol == string_view::npos ? trace.size() : eol + 1;
+            if (!line.empty() && line.back() == '\r') line.remove_suffix(1);
+            if (line.empty() || line[0] == '#') continue;
+
+            vector<string_view> f = splitFields(line);
+            if (f.size() < 3) continue;
+            int64_t t = toInt(f[0]);
+            if (firstMs < 0) firstMs = t;
+            executor.runUntil(t);
+            timeouts.advance();
+            forecaster->tick();
+            m.events++;
+
+            string_view type = f[1];
+            if (type == "booking" && f.size() >= 7) {
+                RideObject* r = new RideObject(string(f[3]), string(f[4]), string(f[2]));
+                r->rideType = string(f[5]);
+                r->vehicle = string(f[6]);
+                r->requestedAtMs = t;
+                bm.submitBooking(r);
+                m.bookings++;
+            } else if (type == "location" && f.size() >= 5) {
+                string name(f[2]), location(f[4]);
+                status.notify(name, location, string(f[3]));
+            } else if (type == "driver" && f.size() >= 5) {
+                Driver* d = new Driver(string(f[2]), string(f[3]));
+                d->currentLocation = string(f[4]);
+                d->availability = true;
+                dm.addDriver(d);
+                fleet[d->name] = d;
+                ratingStore.registerDriver(d);
+                status.notify(d->name, d->currentLocation, d->userType);
+            } else if (type == "cancel") {
+                rideRequestManager->cancelRide(string(f[2]));
+            } else if (type == "rating" && f.size() >= 4) {
+                ratingStore.ingestRating(string(f[2]), (int)toInt(f[3]));
+            }
+        }
+        executor.drain();
+        int64_t endMs = clock.nowMs();
+        m.simulatedMs = firstMs < 0 ? 0 : endMs - firstMs;
+
+        vector<int64_t> pickupEtas;
+        int64_t busyMs = 0;
+        m.accepted = collector->rides.size();
+        m.repositionSuggestions = forecaster->suggestionsSent;
+        for (RideObject* r : collector->rides) {
+            if (!r->driverName.empty()) m.matched++;
+            if (r->rideStatus == "cancelled") m.cancelled++;
+            if (r->completedAtMs > 0) m.completed++;
+            if (r->pickupAtMs > 0) pickupEtas.push_back(r->pickupAtMs - r->requestedAtMs);
+            // A driver is busy from the match until the drop-off or the cancellation
+            int64_t endedAtMs = r->completedAtMs > 0 ? r->completedAtMs : r->cancelledAtMs;
+            if (r->matchedAtMs > 0 && endedAtMs > 0 && fleet.count(r->driverName)) {
+                busyMs += endedAtMs - r->matchedAtMs;
+            }
+        }
+        if (!fleet.empty() && m.simulatedMs > 0) {
+            m.utilization = (double)busyMs / ((double)fleet.size() * (double)m.simulatedMs);
+        }
+        m.matchP50Us = percentile(timedOrchestrator.matchNanos, 0.50) / 1000.0;
+        m.matchP95Us = percentile(timedOrchestrator.matchNanos, 0.95) / 1000.0;
+        m.pickupEtaP50S = percentile(pickupEtas, 0.50) / 1000.0;
+        m.pickupEtaP95S = percentile(pickupEtas, 0.95) / 1000.0;
+        for (RideObject* r : collector->rides) delete r;
+        collector->rides.clear();
+        delete collector;
+        delete forecaster;
+        delete rideRequestManager;
+
+        m.wallMs = chrono::duration<double, milli>(chrono::steady_clock::now() - wallStart).count();
+        return m;
+    }
+};
+
+// Replays one trace per strategy (comma separated) and prints the metrics side by side.
+inline int runReplay(const string& tracePath, const string& strategies) {
+    MappedTraceFile file;
+    if (!file.open(tracePath)) {
+        cout << "Could not open trace file " << tracePath << "\n";
+        return 1;
+    }
+
+    AsyncLogger::instance().setMinLevel(LOG_LEVEL_ERROR); // keep replayed rides out of the log
+    vector<ReplayMetrics> results;
+    size_t pos = 0;
+    while (pos <= strategies.size()) {
+        size_t comma = strategies.find(',', pos);
+        string name = strategies.substr(pos, comma == string::npos ? string::npos : comma - pos);
+        pos = comma == string::npos ? strategies.size() + 1 : comma + 1;
+        if (name.empty()) continue;
+
+        ReplaySimulator sim;
+        cout.setstate(ios::failbit); // the ride flow narrates every step; keep the replay quiet
+        results.push_back(sim.run(file.contents(), name));
+        cout.clear();
+    }
+
+    cout << "\n--- Replay of " << tracePath << " ---\n";
+    for (auto& m : results) {
+        cout << "[" << m.strategy << "] events=" << m.events << " bookings=" << m.bookings << " accepted=" << m.accepted
+             << " matched=" << m.matched << " completed=" << m.completed << " cancelled=" << m.cancelled << "\n"
+             << "  match time p50/p95: " << m.matchP50Us << " / " << m.matchP95Us << " us\n"
+             << "  pickup ETA p50/p95: " << m.pickupEtaP50S << " / " << m.pickupEtaP95S << " s\n"
+             << "  fleet utilization: " << m.utilization * 100 << "%, repositioning suggestions: " << m.repositionSuggestions << "\n"
+             << "  simulated " << m.simulatedMs / 1000.0 << " s in " << m.wallMs << " ms wall time\n";
+    }
+    return 0;
+}